@@ -1,10 +1,15 @@
+#include <stdio.h>
+
 #include "fatfs.h"
+#include "util/scopedirqblocker.h"
 
 #include "wavetable_oscillator.h"
 #include "src/hardware/fourSeasBoard.h"
 #include "src/settings.h"
 #include "src/ui.h"
 #include "src/crash_log.h"
+#include "src/block_pipeline.h"
+#include "src/wave_capture.h"
 
 using namespace daisy;
 using namespace daisysp;
@@ -26,6 +31,15 @@ static constexpr size_t kNumWaveSamples =
     2048;
 #endif
 
+// Reading between wave samples costs 2 (Linear), 4 (Hermite) or 8 (Sinc)
+// taps per corner wave
+using PhaseInterpolation =
+#ifdef CURRENT_PHASE_INTERPOLATION
+    CURRENT_PHASE_INTERPOLATION;
+#else
+    LinearPhase;
+#endif
+
 static constexpr uint8_t kWtAudio1 = Ui::WT_OSCS::WT_AUDIO_1;
 static constexpr uint8_t kWtAudio2 = Ui::WT_OSCS::WT_AUDIO_2;
 static constexpr uint8_t kWtAudio3 = Ui::WT_OSCS::WT_AUDIO_3;
@@ -58,13 +72,63 @@ extern SD_HandleTypeDef hsd1;
 // ============================================================================
 // Synthesis Engine
 // ============================================================================
-static WavetableOscillator<kNumWaveSamples, true, true>
+static WavetableOscillator<kNumWaveSamples, true, true, PhaseInterpolation>
     wto_full[2]; // A1, B1 - full features
-static WavetableOscillator<kNumWaveSamples, false, false>
+static WavetableOscillator<kNumWaveSamples, false, false, PhaseInterpolation>
     wto_basic[2]; // A2, B2 - basic only
 
-static float          wt_outs[Ui::WT_OSCS::WT_OSCS_LAST];
-static Params::Values vals[4];
+// Decimation applied while an output is in LFO mode (A1, B1, A2, B2).
+// The full oscillators sample their PM input at the decimated rate, so they
+// get a finer grid than the basic ones. 1 keeps an output at full rate.
+static constexpr size_t kLfoDecimation[4] = {8, 8, 16, 16};
+
+// Oversampling for the WAVESHAPING and XOR modes of the full oscillators.
+// Costs roughly this many times one oscillator while either mode is active.
+static constexpr size_t kModOversampling = 2;
+
+// Unison / chord voices are capped from the measured callback load. The cap
+// drops a voice as soon as a block runs hot, and only climbs one voice at a
+// time after a whole window has run cool at the current cap, so asking for
+// more voices ramps them in rather than overrunning the callback.
+static CpuLoadMeter load_meter;
+static size_t       voice_limit = 1;
+static size_t       voice_hold  = 0;
+
+static constexpr float kVoiceLoadHigh = 0.85f;
+static constexpr float kVoiceLoadLow  = 0.6f;
+static constexpr float kVoiceHoldTime = 0.1f; // seconds
+
+static size_t voice_hold_blocks;
+
+// Bank changes are applied by the audio callback at a block boundary and
+// crossfaded over kBankFadeTime. A fade that overlaps a block above
+// kBankFadeLoadHigh is cut short to end within the next block, as it
+// costs an extra uncached wave read per voice while it runs. That goes by
+// the block's own load: the meter's max holds a spike for up to
+// kVoiceHoldTime, far longer than the fade.
+static constexpr float kBankFadeTime     = 0.01f; // seconds
+static constexpr float kBankFadeLoadHigh = 0.75f;
+
+static size_t  bank_fade_samples;
+static uint8_t active_bank    = 0;
+static bool    bank_fade_over = false;
+
+// Ticks spent on a block times this is its load
+static float block_load_scale;
+
+// Optional one-block-ahead rendering (AudioConfig::pipelined). The render
+// runs in the handler of an IRQ no peripheral on the board uses, pended
+// by the audio callback at the lowest priority.
+static constexpr size_t    kNumAudioChannels = 4;
+static constexpr IRQn_Type kRenderIRQn       = SWPMI1_IRQn;
+
+static BlockPipeline<kNumAudioChannels> pipeline;
+
+// Highest callback load seen since audio started, for LogAudioLoad()
+static float peak_load = 0.0f;
+
+// How long audio runs before its load is logged to the SD card
+static constexpr uint32_t kLoadLogDelayMs = 10000;
 
 // ============================================================================
 // Wavetable Storage (SDRAM)
@@ -77,6 +141,21 @@ static float DSY_SDRAM_BSS __attribute__((aligned(
 alignas(32) static float* DSY_SDRAM_BSS
     wave_offsets[kNumWaves * kNumCols * kNumPages * kNumBanks];
 
+// Live capture from the A mod input into the selected bank and page
+static constexpr size_t kWavesPerPage = kNumWaves * kNumCols;
+
+static float DSY_SDRAM_BSS capture_scratch[kNumWaveSamples * kWavesPerPage];
+static float DSY_SDRAM_BSS capture_staging[kNumWaveSamples * kWavesPerPage];
+static WaveCapture         capture;
+static uint8_t             capture_bank;
+static uint8_t             capture_page;
+
+static float* PageData(size_t bank_idx, size_t page_idx)
+{
+    return &table[(bank_idx * kNumPages + page_idx) * kWavesPerPage
+                  * kNumWaveSamples];
+}
+
 // ============================================================================
 // Persistent Settings
 // ============================================================================
@@ -93,102 +172,300 @@ static CrashLogger crash_logger(hw.seed.qspi);
 // Track if audio is running (for crash context)
 static volatile bool audio_active = false;
 
+// Between StartAudio() and StopAudio()
+static bool audio_started = false;
+
 // ============================================================================
 // Audio Callback & Helper Functions
 // ============================================================================
 
-static void AudioCallback(AudioHandle::InputBuffer  in,
-                          AudioHandle::OutputBuffer out,
-                          size_t                    size)
+static void UpdateVoiceLimit(size_t requested)
+{
+    const float load = load_meter.GetMaxCpuLoad();
+    if(load > kVoiceLoadHigh)
+    {
+        voice_limit = voice_limit > 1 ? voice_limit - 1 : 1;
+        voice_hold  = voice_hold_blocks;
+        load_meter.Reset();
+        return;
+    }
+
+    // Only voices that have been measured count as headroom
+    voice_limit = std::min(voice_limit, std::max(requested, size_t(1)));
+
+    if(voice_hold > 0)
+    {
+        voice_hold--;
+        return;
+    }
+
+    if(load < kVoiceLoadLow && voice_limit < requested)
+    {
+        voice_limit++;
+    }
+    voice_hold = voice_hold_blocks;
+    load_meter.Reset();
+}
+
+// Renders one block, either straight from the audio callback or one
+// block ahead of it from the render interrupt
+static void RenderBlock(AudioHandle::InputBuffer  in,
+                        AudioHandle::OutputBuffer out,
+                        size_t                    size)
 {
     audio_active = true;
+    load_meter.OnBlockStart();
+    const uint32_t block_start = System::GetTick();
+
+    capture.Record(in[kWtModA], size);
 
     // input (should) scale from -1 to 1.
     // 10vpp yields -0.640790105 to 0.64958632
     // this gives us some headroom for louder signals before clipping
-    ui.UpdateParams(); // get current UI x and init all 4 interpolators with it
+    ui.UpdateParams(); // get current UI x and compute all 4 targets from it
+
+    // Audio-rate FM and position CV, shared by all four oscillators
+    const CvRamps& cv_ramps = ui.GetCvRamps();
 
     bool interpolate = ui.state_->interpolate_waves;
-    bool osc_sync_1  = false;
-    bool osc_sync_2  = false;
-
-    // Audio Loop
-    for(size_t i = 0; i < size; i++)
-    {
-        // GetParams returns interpolated data for each parameter in one call
-        // It should be called once per sample
-        vals[kWtAudio4] = ui.GetParams(kWtAudio4);
-        vals[kWtAudio3] = ui.GetParams(kWtAudio3);
-        vals[kWtAudio1] = ui.GetParams(kWtAudio1);
-        vals[kWtAudio2] = ui.GetParams(kWtAudio2);
-
-        osc_sync_1 = (in[kWtSyncA][i] > 0.05f);
-        osc_sync_2 = (in[kWtSyncB][i] > 0.05f);
-
-        OscillatorParams osc_params[4] = {
-            {vals[kWtAudio1],
-             interpolate,
-             ui.state_->mod_state_1,
-             in[kWtModA][i],
-             ui.state_->sync_mode_1,
-             osc_sync_1},
-
-            {vals[kWtAudio3],
-             interpolate,
-             ui.state_->mod_state_2,
-             in[kWtModB][i],
-             ui.state_->sync_mode_2,
-             osc_sync_2},
-
-            {vals[kWtAudio2], interpolate},
-            {vals[kWtAudio4], interpolate},
-        };
-
-        // Full-featured oscillators (compile ALL features)
-        wto_full[0].Render(osc_params[0], &wt_outs[0]); // A1
-        wto_full[1].Render(osc_params[1], &wt_outs[1]); // B1
-
-        // Basic oscillators (compile NO mod/sync code)
-        wto_basic[0].Render(osc_params[2], &wt_outs[2]); // A2
-        wto_basic[1].Render(osc_params[3], &wt_outs[3]); // B2
-
-        // Process
-        out[0][i] = wt_outs[kWtAudio4]; // B2
-        out[1][i] = wt_outs[kWtAudio2]; // B1
-        out[2][i] = wt_outs[kWtAudio1];
-
-        // A1 = 0, B1 = 1, A2 = 2, B2 = 3
-        // 1+2 are onboard
-        // 3+4 are external
-        // but! ext is rendered first due to weirdness in libDaisy
-        // so really:
-        // 1 = out[2]
-        // 2 = out[3]
-        // 3 = out[1]
-        // 4 = out[0]
-
-        if constexpr(fourseas::FourSeasHW::kCurrentBoardRevVar
-                     == FourSeasHW::BoardRevision::REV_3)
+
+    // LFO mode outputs are sub-audio, render them at a fraction of the rate
+    const bool lfo_1 = ui.state_->lfo_state_1;
+    const bool lfo_2 = ui.state_->lfo_state_2;
+    wto_full[0].SetDecimation(lfo_1 ? kLfoDecimation[0] : 1);
+    wto_full[1].SetDecimation(lfo_2 ? kLfoDecimation[1] : 1);
+    wto_basic[0].SetDecimation(lfo_1 ? kLfoDecimation[2] : 1);
+    wto_basic[1].SetDecimation(lfo_2 ? kLfoDecimation[3] : 1);
+
+    const uint8_t bank = ui.GetBankNum();
+    if(bank != active_bank)
+    {
+        for(auto& osc : wto_full)
         {
-            out[3][i] = wt_outs[kWtAudio3] * -1.0f; // A2
+            osc.SetBank(bank, bank_fade_samples);
         }
-        else
+        for(auto& osc : wto_basic)
+        {
+            osc.SetBank(bank, bank_fade_samples);
+        }
+        active_bank = bank;
+    }
+    if(bank_fade_over)
+    {
+        for(auto& osc : wto_full)
+        {
+            osc.LimitFade(size);
+        }
+        for(auto& osc : wto_basic)
+        {
+            osc.LimitFade(size);
+        }
+    }
+
+    const VoiceSpread& voices = ui.GetVoices();
+    for(auto& osc : wto_full)
+    {
+        osc.SetVoices(voices, voice_limit);
+    }
+    for(auto& osc : wto_basic)
+    {
+        osc.SetVoices(voices, voice_limit);
+    }
+
+    // Each oscillator ramps only the parameters it uses towards its target
+    wto_full[0].Update(ui.GetTargets(kWtAudio1), size);
+    wto_full[1].Update(ui.GetTargets(kWtAudio3), size);
+    wto_basic[0].Update(ui.GetTargets(kWtAudio2), size);
+    wto_basic[1].Update(ui.GetTargets(kWtAudio4), size);
+
+    OscillatorParams osc_params[4] = {
+        {interpolate,
+         ui.state_->mod_state_1,
+         in[kWtModA],
+         ui.state_->sync_mode_1,
+         in[kWtSyncA]},
+
+        {interpolate,
+         ui.state_->mod_state_2,
+         in[kWtModB],
+         ui.state_->sync_mode_2,
+         in[kWtSyncB]},
+
+        {interpolate},
+        {interpolate},
+    };
+
+    // A1 = 0, B1 = 1, A2 = 2, B2 = 3
+    // 1+2 are onboard
+    // 3+4 are external
+    // but! ext is rendered first due to weirdness in libDaisy
+    // so really:
+    // 1 = out[2]
+    // 2 = out[3]
+    // 3 = out[1]
+    // 4 = out[0]
+
+    // Full-featured oscillators (compile ALL features)
+    wto_full[0].Render(osc_params[0], cv_ramps, out[2], size); // A1
+    wto_full[1].Render(osc_params[1], cv_ramps, out[1], size); // B1
+
+    // Basic oscillators (compile NO mod/sync code)
+    wto_basic[0].Render(osc_params[2], cv_ramps, out[3], size); // A2
+    wto_basic[1].Render(osc_params[3], cv_ramps, out[0], size); // B2
+
+    if constexpr(fourseas::FourSeasHW::kCurrentBoardRevVar
+                 == FourSeasHW::BoardRevision::REV_3)
+    {
+        for(size_t i = 0; i < size; i++)
+        {
+            out[3][i] *= -1.0f; // A2
+        }
+    }
+
+    const float block_load
+        = static_cast<float>(System::GetTick() - block_start)
+          * block_load_scale;
+    bank_fade_over = block_load > kBankFadeLoadHigh;
+
+    load_meter.OnBlockEnd();
+    peak_load = std::max(peak_load, load_meter.GetMaxCpuLoad());
+    UpdateVoiceLimit(voices.count);
+}
+
+static void AudioCallback(AudioHandle::InputBuffer  in,
+                          AudioHandle::OutputBuffer out,
+                          size_t                    size)
+{
+    RenderBlock(in, out, size);
+}
+
+// Pipelined mode: swap blocks with the renderer and wake it up
+static void PipelinedAudioCallback(AudioHandle::InputBuffer  in,
+                                   AudioHandle::OutputBuffer out,
+                                   size_t /*size*/)
+{
+    pipeline.Exchange(in, out);
+    NVIC_SetPendingIRQ(kRenderIRQn);
+}
+
+// Renders every block the callback has queued, in the render interrupt
+static void RenderPendingBlocks()
+{
+    using Block = BlockPipeline<kNumAudioChannels>::Block;
+
+    Block* block;
+    while((block = pipeline.Next()) != nullptr)
+    {
+        const float* in[kNumAudioChannels];
+        float*       out[kNumAudioChannels];
+        for(size_t c = 0; c < kNumAudioChannels; c++)
         {
-            out[3][i] = wt_outs[kWtAudio3]; // A2
+            in[c]  = block->in[c];
+            out[c] = block->out[c];
         }
+        RenderBlock(in, out, pipeline.BlockSize());
+        pipeline.Done(block);
     }
 }
 
+static void StartAudio()
+{
+    if(hw.GetAudioConfig().pipelined)
+    {
+        pipeline.Init(hw.AudioBlockSize());
+
+        // Below every other interrupt, so they delay the render instead of
+        // the codec
+        HAL_NVIC_SetPriority(kRenderIRQn, 15, 15);
+        HAL_NVIC_EnableIRQ(kRenderIRQn);
+        hw.StartAudio(PipelinedAudioCallback);
+    }
+    else
+    {
+        hw.StartAudio(AudioCallback);
+    }
+    audio_started = true;
+}
+
+// Records into the selected bank and page, optionally saving over its file
+static void StartCapture(bool save)
+{
+    const uint8_t bank = ui.GetBankNum();
+    const uint8_t page = ui.GetPageNum();
+
+    char path[20];
+    snprintf(path, sizeof(path), "/%d/%d.wav", bank + 1, page + 1);
+
+    if(capture.Start(PageData(bank, page), save ? path : nullptr))
+    {
+        capture_bank = bank;
+        capture_page = page;
+    }
+}
+
+// Points the oscillators at the captured waves, wherever they are now.
+// With interrupts off no block is mid-render, so every oscillator switches
+// over between two blocks and none keeps a blend of the old waves.
+static void PublishCapture(float* waves)
+{
+    const size_t first = (capture_bank * kNumPages + capture_page)
+                         * kWavesPerPage;
+
+    daisy::ScopedIrqBlocker irq_blocker;
+    for(size_t j = 0; j < kWavesPerPage; j++)
+    {
+        wave_offsets[first + j] = &waves[j * kNumWaveSamples];
+    }
+    for(auto& osc : wto_full)
+    {
+        osc.InvalidateBlend();
+    }
+    for(auto& osc : wto_basic)
+    {
+        osc.InvalidateBlend();
+    }
+}
+
+static void StopAudio()
+{
+    hw.StopAudio();
+    HAL_NVIC_DisableIRQ(kRenderIRQn);
+    audio_started = false;
+}
+
 static void InitSynth()
 {
+    const AudioConfig& config = hw.GetAudioConfig();
+
+    capture.Init(capture_scratch,
+                 capture_staging,
+                 kNumWaveSamples,
+                 kWavesPerPage,
+                 config.sample_rate);
+
+    load_meter.Init(config.sample_rate, config.block_size);
+    block_load_scale = config.sample_rate
+                       / (static_cast<float>(config.block_size)
+                          * static_cast<float>(System::GetTickFreq()));
+    voice_hold_blocks = config.Blocks(kVoiceHoldTime);
+    bank_fade_samples = config.Samples(kBankFadeTime);
+    peak_load         = 0.0f;
+
+    // Oscillators start on the first bank, the callback fades to the
+    // selected one
+    active_bank = 0;
+
     for(auto& osc : wto_full)
     {
         osc.Init(wave_offsets);
+        osc.SetSampleRate(config.sample_rate);
+        osc.SetOversampling(kModOversampling);
     }
 
     for(auto& osc : wto_basic)
     {
         osc.Init(wave_offsets);
+        osc.SetSampleRate(config.sample_rate);
     }
 }
 
@@ -223,6 +500,82 @@ static bool InitSDCardFileSystem()
     return true;
 }
 
+// Default profile, overridden by /audio.cfg if the card has one
+static AudioConfig LoadAudioConfig()
+{
+    AudioConfig config = AudioConfig::FromProfile(AudioConfig::DEFAULT);
+
+    if(f_open(&SDFile, "/audio.cfg", FA_READ) == FR_OK)
+    {
+        char text[256];
+        UINT bytes_read;
+        if(f_read(&SDFile, text, sizeof(text), &bytes_read) == FR_OK)
+        {
+            config.Parse(text, bytes_read);
+        }
+        f_close(&SDFile);
+    }
+
+    return config;
+}
+
+// Appends the audio setup, its measured callback load, any pipeline
+// underruns, how the CV ADC and the panel I2C bus are keeping up and how
+// long button events wait for the UI to /audio_load.txt, so each rack
+// builds up a load table. `adc_ms` is how long the ADC has been up.
+static void LogAudioLoad(uint32_t adc_ms)
+{
+    if(f_open(&SDFile, "/audio_load.txt", FA_WRITE | FA_OPEN_APPEND) != FR_OK)
+    {
+        return;
+    }
+
+    const AudioConfig& config = hw.GetAudioConfig();
+
+    const AdcMCP3564R::ScanTiming adc     = hw.adc_.GetScanTiming();
+    const I2CBus::Stats           i2c     = hw.GetPanelI2C().GetStats();
+    const Buttons::Latency        buttons = hw.buttons.GetLatency();
+
+    char line[320];
+    int  length = snprintf(
+        line,
+        sizeof(line),
+        "%u Hz, %u samples%s: avg %u%%, peak %u%%, %lu underruns; "
+        "adc%s: osr %lu, %lu irq/s, scan %u us, jitter %u us, %lu resyncs; "
+        "i2c: busy %u%%, wait %lu/%lu us (buttons), %lu/%lu us (leds), "
+        "%lu timeouts%s; buttons: %lu/%lu us, %lu dropped\n",
+        static_cast<unsigned>(config.sample_rate),
+        static_cast<unsigned>(config.block_size),
+        config.pipelined ? " pipelined" : "",
+        static_cast<unsigned>(load_meter.GetAvgCpuLoad() * 100.0f),
+        static_cast<unsigned>(peak_load * 100.0f),
+        static_cast<unsigned long>(pipeline.Underruns()),
+        hw.adc_.IsStreaming() ? " stream" : "",
+        static_cast<unsigned long>(
+            AdcScheduler::Ratio(ui.GetAdcScheduler().Osr())),
+        static_cast<unsigned long>(
+            adc_ms > 0 ? 1000ull * adc.interrupts / adc_ms : 0),
+        static_cast<unsigned>(adc.period_us + 0.5f),
+        static_cast<unsigned>(adc.max_jitter_us + 0.5f),
+        static_cast<unsigned long>(hw.adc_.GetSyncErrors()),
+        static_cast<unsigned>(i2c.utilisation * 100.0f + 0.5f),
+        static_cast<unsigned long>(i2c.wait_avg_us[I2CBus::PRIORITY_HIGH]),
+        static_cast<unsigned long>(i2c.wait_max_us[I2CBus::PRIORITY_HIGH]),
+        static_cast<unsigned long>(i2c.wait_avg_us[I2CBus::PRIORITY_LOW]),
+        static_cast<unsigned long>(i2c.wait_max_us[I2CBus::PRIORITY_LOW]),
+        static_cast<unsigned long>(i2c.timeouts),
+        i2c.stuck ? " (stuck)" : "",
+        static_cast<unsigned long>(buttons.avg_us),
+        static_cast<unsigned long>(buttons.max_us),
+        static_cast<unsigned long>(buttons.dropped));
+    if(length > 0)
+    {
+        UINT written;
+        f_write(&SDFile, line, static_cast<UINT>(length), &written);
+    }
+    f_close(&SDFile);
+}
+
 // Returns true on success, false on fatal error
 // Note: Partial success (at least 1 bank loaded) returns true
 static bool LoadWavetables()
@@ -246,10 +599,8 @@ static bool LoadWavetables()
                      bank_idx + 1,
                      page_idx + 1);
 
-            wtl.Init(
-                &table[(bank_idx * bank_offset * kNumWaveSamples)
-                       + page_idx * kNumWaveSamples * kNumWaves * kNumCols],
-                kNumWaveSamples * kNumWaves * kNumCols);
+            wtl.Init(PageData(bank_idx, page_idx),
+                     kNumWaveSamples * kNumWaves * kNumCols);
             wtl.SetWaveTableInfo(kNumWaveSamples, kNumWaves * kNumCols);
 
             WaveTableLoader::Result res = WaveTableLoader::Result::ERR_GENERIC;
@@ -286,10 +637,7 @@ static bool LoadWavetables()
             else
             {
                 // Fatal error - no banks loaded, show red LEDs
-                for(uint8_t i = 0; i < 3; i++)
-                {
-                    ui.FadeToColor(255, 0, 0, 1000);
-                }
+                ui.FadeToColor(255, 0, 0, 1000, 3);
                 return false;
             }
         }
@@ -300,6 +648,7 @@ static bool LoadWavetables()
 static void GPIOTimerCB(void* data)
 {
     hw.UpdateExtGPIO();
+    ui.TickLEDs();
 }
 
 
@@ -383,6 +732,18 @@ extern "C"
     {
         HAL_GPIO_EXTI_IRQHandler(GPIO_PIN_1);
     }
+
+    // Half and full buffer events of the CV ADC stream (ADC_STREAMING)
+    void DMA2_Stream4_IRQHandler()
+    {
+        hw.adc_.HandleStreamInterrupt();
+    }
+
+    // Pended by PipelinedAudioCallback(), see kRenderIRQn
+    void SWPMI1_IRQHandler()
+    {
+        RenderPendingBlocks();
+    }
 }
 
 void TriggerTestCrash()
@@ -396,6 +757,8 @@ auto main() -> int
 {
     hw.Init(true);
 
+    uint32_t audio_start_ms = 0;
+
     // Initialize crash logger to read existing crash count
     crash_logger.Init();
 
@@ -443,6 +806,9 @@ auto main() -> int
 
     ui.Init(&hw, &settings_storage, &app_state_storage);
 
+    // LED animations run from the timer, so it goes before any loading
+    InitTimer();
+
     // Initialize SD card and dump crash logs (if any)
     if(InitSDCardFileSystem())
     {
@@ -478,11 +844,16 @@ auto main() -> int
             }
         }
 
+        hw.ConfigureAudio(LoadAudioConfig());
+        // The params copied the controls at the rate they had before
+        ui.InitControls();
+
         if(LoadWavetables())
         {
             InitSynth();
-            hw.StartAudio(AudioCallback);
+            StartAudio();
             ui.SetWavesLoaded(true);
+            audio_start_ms = hw.GetNow();
         }
         else
         {
@@ -494,14 +865,19 @@ auto main() -> int
         ui.SetWavesLoaded(false);
     }
 
-    InitTimer();
     hw.StartAdc();
 
+    hw.adc_.ResetScanTiming();
+    const uint32_t adc_start_ms = hw.GetNow();
+#if ADC_STREAMING
+    hw.adc_.StartStreaming();
+#else
     /* EXTI interrupt init for ADC data ready timer */
     HAL_NVIC_SetPriority(EXTI1_IRQn, 1, 1);
     HAL_NVIC_EnableIRQ(EXTI1_IRQn);
+#endif
 
-    uint8_t last_bank = 0;
+    bool load_logged = false;
 
     // crash here - uncomment as needed for testing / debugging
     // TriggerTestCrash();
@@ -510,27 +886,34 @@ auto main() -> int
     {
         hw.RefreshWatchdog();
 
-        bool    freshly_calibrated = ui.Process();
-        uint8_t bank               = ui.GetBankNum();
-        if(bank != last_bank)
+        bool freshly_calibrated = ui.Process();
+
+        const Ui::CaptureRequest request = ui.TakeCaptureRequest();
+        if(request != Ui::CAPTURE_NONE && audio_active)
         {
-            for(auto& osc : wto_full)
-            {
-                osc.SetBank(bank);
-            }
+            StartCapture(request == Ui::CAPTURE_AND_SAVE);
+        }
+        if(capture.Process())
+        {
+            PublishCapture(capture.GetOutput());
+        }
 
-            for(auto& osc : wto_basic)
-            {
-                osc.SetBank(bank);
-            }
-            last_bank = bank;
+        if(!load_logged && audio_active
+           && hw.GetNow() - audio_start_ms > kLoadLogDelayMs)
+        {
+            LogAudioLoad(hw.GetNow() - adc_start_ms);
+            load_logged = true;
         }
 
         // Hot reload wavetables when both LFO toggle buttons held >2s
-        if(hw.buttons[Ui::SW_LFO_TOGGLE_1].TimeHeldMs() > 2000
-           && hw.buttons[Ui::SW_LFO_TOGGLE_2].TimeHeldMs() > 2000)
+        if(hw.buttons.TimeHeldMs(Ui::SW_LFO_TOGGLE_1) > 2000
+           && hw.buttons.TimeHeldMs(Ui::SW_LFO_TOGGLE_2) > 2000)
         {
-            hw.StopAudio();
+            StopAudio();
+
+            // A save still running has its file open on the card, and
+            // the page it records into is about to be reloaded anyway
+            capture.Abort();
 
             // Unmount and deinit SD card hardware
             f_mount(nullptr, "/", 1);
@@ -546,7 +929,7 @@ auto main() -> int
                 if(LoadWavetables())
                 {
                     InitSynth();
-                    hw.StartAudio(AudioCallback);
+                    StartAudio();
                     ui.SetWavesLoaded(true);
                 }
                 else
@@ -560,9 +943,20 @@ auto main() -> int
             }
         }
 
+        // The callback reads the controls and params this rebuilds, so it
+        // can't run meanwhile; the scan stream and scheduler are left be
         if(freshly_calibrated)
         {
-            ui.Init(&hw, &settings_storage, &app_state_storage);
+            const bool was_started = audio_started;
+            if(was_started)
+            {
+                StopAudio();
+            }
+            ui.InitControls();
+            if(was_started)
+            {
+                StartAudio();
+            }
         }
     }
 }
@@ -0,0 +1,393 @@
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <random>
+#include <sstream>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+#include "src/drivers/MCP3564R_words.h"
+
+#include "bench/bench.h"
+
+/**
+    Replays the ADCDATA reads in adc_frames.txt through the MCP3564R word
+    decoding (src/drivers/MCP3564R_words.h) and checks what comes out:
+    values and overrange either side of full scale, reads that slipped a
+    byte, channels out of SCAN order, and the stream walk finding its word
+    boundary again, also across the 2^32 wrap of its byte counters. Exits
+    non-zero if any frame decodes wrong. Then times a burst through the
+    checked decoding against the unchecked one it replaced.
+*/
+namespace
+{
+struct Frame
+{
+    uint8_t              scan_channels;
+    std::vector<uint8_t> bytes;
+};
+
+std::map<std::string, Frame> LoadFrames(const char* path)
+{
+    std::map<std::string, Frame> frames;
+    std::ifstream                file(path);
+    std::string                  line;
+    Frame*                       frame = nullptr;
+    while(std::getline(file, line))
+    {
+        std::istringstream fields(line);
+        std::string        first;
+        if(!(fields >> first) || first[0] == '#')
+        {
+            continue;
+        }
+        if(first == "frame")
+        {
+            std::string name;
+            unsigned    scan;
+            fields >> name >> std::hex >> scan;
+            frame                = &frames[name];
+            frame->scan_channels = static_cast<uint8_t>(scan);
+            continue;
+        }
+        fields.clear();
+        fields.str(line);
+        unsigned byte;
+        while(frame && fields >> std::hex >> byte)
+        {
+            frame->bytes.push_back(static_cast<uint8_t>(byte));
+        }
+    }
+    return frames;
+}
+
+size_t failures = 0;
+
+void Expect(bool ok, const char* frame, const char* what)
+{
+    if(!ok)
+    {
+        printf("FAIL  %s: %s\n", frame, what);
+        failures++;
+    }
+}
+
+// Words of one burst read, walked as endCallback_() walks them; returns
+// how many are in place before the first that is not
+size_t InOrder(const Frame& frame, AdcWord* words)
+{
+    AdcScanOrder order;
+    order.Set(frame.scan_channels);
+
+    const size_t count = frame.bytes.size() / 4;
+    DecodeWords(frame.bytes.data(), count, order.channels, words);
+
+    uint32_t take;
+    return WalkBurst(words, count, order, take);
+}
+
+void FullScale(const Frame& frame)
+{
+    static const int32_t kValues[8]
+        = {0, -1, 0x7fffff, -0x800000, 0x800005, -0x800007, 123456, -654321};
+
+    AdcWord words[8];
+    Expect(InOrder(frame, words) == 8, "full_scale", "all eight in order");
+    for(size_t i = 0; i < 8; i++)
+    {
+        Expect(words[i].ch_idx == i, "full_scale", "channel id");
+        Expect(words[i].value == kValues[i], "full_scale", "value");
+
+        // Only 0x800005 and -0x800007 are past full scale
+        Expect(words[i].overrange == (i == 4 || i == 5),
+               "full_scale",
+               "overrange");
+    }
+}
+
+void BadSgn(const Frame& frame)
+{
+    AdcWord words[8];
+    Expect(InOrder(frame, words) == 2, "bad_sgn", "stops at channel 2");
+    for(size_t i = 0; i < 8; i++)
+    {
+        Expect(words[i].valid == (i != 2 && i != 5),
+               "bad_sgn",
+               "only all-0 or all-1 SGN is valid");
+    }
+}
+
+void Misaligned(const Frame& frame)
+{
+    AdcWord words[8];
+    Expect(InOrder(frame, words) == 3, "misaligned", "stops at the slip");
+
+    // One byte early, the fourth word still looks like a good channel 0
+    Expect(words[3].valid && words[3].ch_idx == 0,
+           "misaligned",
+           "the slipped word decodes");
+}
+
+void Unscanned(const Frame& frame)
+{
+    AdcWord words[8];
+    Expect(InOrder(frame, words) == 4, "unscanned", "stops at channel 3");
+    Expect(!words[4].valid, "unscanned", "channel 3 is not scanned");
+
+    AdcScanOrder mux;
+    mux.Set(0);
+    Expect(mux.channels == 0xff && mux.next[3] == kAdcNoChannel,
+           "unscanned",
+           "SCAN at 0 checks no order");
+}
+
+struct Taken
+{
+    int32_t  value;
+    uint8_t  ch_idx;
+    bool     overrange;
+    uint32_t end; // stream position just past the word, from the start
+};
+
+/**
+    The stream as ProcessStream() sees it, a half buffer at a time, with
+    byte 0 of `frame` at stream position `start`. Counts LOST_SYNC steps
+    into `lost`.
+*/
+std::vector<Taken> Walk(const Frame& frame, uint32_t start, size_t* lost)
+{
+    const size_t ring_bytes = frame.bytes.size();
+    const size_t half       = ring_bytes / 2;
+
+    // Where the DMA would have put each byte of the ring
+    std::vector<uint8_t> ring(ring_bytes);
+    for(size_t i = 0; i < ring_bytes; i++)
+    {
+        ring[(start + i) % ring_bytes] = frame.bytes[i];
+    }
+
+    AdcScanOrder order;
+    order.Set(frame.scan_channels);
+
+    AdcWordStream stream;
+    stream.Reset(start + 1); // after the command byte
+
+    std::vector<Taken> taken;
+    *lost             = 0;
+    uint32_t received = start;
+    for(size_t h = 0; h < 2; h++)
+    {
+        received += half;
+        AdcWord             word;
+        AdcWordStream::Step step;
+        while((step = stream.Next(
+                   ring.data(), ring_bytes, received, order, word))
+              != AdcWordStream::NEED_BYTES)
+        {
+            if(step == AdcWordStream::LOST_SYNC)
+            {
+                (*lost)++;
+                continue;
+            }
+            taken.push_back({word.value,
+                             word.ch_idx,
+                             word.overrange,
+                             stream.Position() - start});
+        }
+    }
+    return taken;
+}
+
+// Conversion k of stream_slip: channel k % 8, and one past full scale
+int32_t SlipValue(size_t k)
+{
+    return k == 13 ? -0x800003 : static_cast<int32_t>(k) * 10 - 500;
+}
+
+void StreamSlip(const Frame& frame)
+{
+    size_t                   lost;
+    const std::vector<Taken> taken = Walk(frame, 0, &lost);
+
+    Expect(lost == 1, "stream_slip", "one lost word boundary");
+
+    // Every word taken is a real conversion, in order, and only the one
+    // with the lost byte is missed
+    size_t k      = 0;
+    size_t missed = 0;
+    for(const Taken& word : taken)
+    {
+        while(k < 64 && SlipValue(k) != word.value)
+        {
+            k++;
+            missed++;
+        }
+        Expect(k < 64 && word.ch_idx == k % 8,
+               "stream_slip",
+               "a conversion that was read");
+        Expect(word.overrange == (k == 13), "stream_slip", "overrange");
+        k++;
+    }
+    Expect(missed <= 1, "stream_slip", "at most one conversion missed");
+    Expect(taken.size() >= 40, "stream_slip", "reads the whole buffer");
+
+    // The same bytes with the counters about to wrap
+    size_t                   wrapped_lost;
+    const std::vector<Taken> wrapped
+        = Walk(frame, 0xffffff00u, &wrapped_lost);
+    bool same = wrapped_lost == lost && wrapped.size() == taken.size();
+    for(size_t i = 0; same && i < taken.size(); i++)
+    {
+        same = wrapped[i].value == taken[i].value
+               && wrapped[i].end == taken[i].end;
+    }
+    Expect(same, "stream_slip", "same words across the counter wrap");
+
+    printf("stream_slip: %zu words, %zu missed, %zu resync\n",
+           taken.size(),
+           missed,
+           lost);
+}
+int32_t          channel_values[kAdcNumChannels];
+volatile int32_t sink;
+
+// The burst decode before the sign and order checks: a nonzero SGN read
+// as 0, and CHID taken on trust
+uint8_t UncheckedBurst(const uint8_t* bytes)
+{
+    uint8_t fresh = 0;
+    for(size_t i = 0; i < 8; i++)
+    {
+        const uint8_t* word   = &bytes[4 * i];
+        const uint8_t  ch_idx = word[0] >> 4;
+        if(ch_idx >= kAdcNumChannels)
+        {
+            continue;
+        }
+        channel_values[ch_idx]
+            = (word[0] & 0xf) ? 0 : word[1] << 16 | word[2] << 8 | word[3];
+        fresh |= 1 << ch_idx;
+    }
+    return fresh;
+}
+
+// What endCallback_() does with a burst
+uint8_t CheckedBurst(const uint8_t* bytes, const AdcScanOrder& order)
+{
+    AdcWord words[8];
+    DecodeWords(bytes, 8, order.channels, words);
+
+    uint32_t take;
+    WalkBurst(words, 8, order, take);
+
+    uint8_t fresh = 0;
+    for(size_t i = 0; i < 8; i++)
+    {
+        if(take & (1u << i))
+        {
+            channel_values[words[i].ch_idx] = words[i].value;
+            fresh |= 1 << words[i].ch_idx;
+        }
+    }
+    return fresh;
+}
+
+// Per 8-word burst, best of a few runs, cycling through `bursts`
+void TimeBursts(const char*                 name,
+                const std::vector<uint8_t>& bursts,
+                const AdcScanOrder&         order)
+{
+    static constexpr size_t kReads = 1 << 20;
+
+    const size_t count = bursts.size() / 32;
+
+    double unchecked = 1e9;
+    double checked   = 1e9;
+    for(size_t run = 0; run < 5; run++)
+    {
+        for(bool check : {false, true})
+        {
+            uint32_t         fresh = 0;
+            bench::Stopwatch watch;
+            watch.Start();
+            for(size_t r = 0; r < kReads; r++)
+            {
+                const uint8_t* bytes = &bursts[(r % count) * 32];
+                fresh += check ? CheckedBurst(bytes, order)
+                               : UncheckedBurst(bytes);
+            }
+            double& best = check ? checked : unchecked;
+            best         = std::min(best, watch.Ns(kReads));
+            sink         = fresh + channel_values[0];
+        }
+    }
+    printf("  %-12s  %7.1f  %9.1f\n", name, checked, unchecked);
+}
+
+/**
+    Bursts where each channel keeps its sign (copies of full_scale with
+    their low data bytes varied) and where signs are random, as for CVs
+    sitting near 0 V. The unchecked decode branches on the sign.
+*/
+void Timing(const Frame& frame)
+{
+    static constexpr size_t kBursts = 4096;
+
+    AdcScanOrder order;
+    order.Set(frame.scan_channels);
+
+    std::vector<uint8_t> steady;
+    std::vector<uint8_t> random;
+    std::mt19937         rng(1);
+    for(size_t b = 0; b < kBursts; b++)
+    {
+        steady.insert(steady.end(), frame.bytes.begin(), frame.bytes.end());
+        for(size_t i = 0; i < 8; i++)
+        {
+            steady[steady.size() - 1 - 4 * i] ^= static_cast<uint8_t>(b);
+
+            const int32_t value
+                = static_cast<int32_t>(rng() % 0x1000000) - 0x800000;
+            const uint32_t raw = static_cast<uint32_t>(i) << 28
+                                 | (static_cast<uint32_t>(value) & 0xfffffff);
+            random.push_back(raw >> 24);
+            random.push_back(raw >> 16);
+            random.push_back(raw >> 8);
+            random.push_back(raw);
+        }
+    }
+
+    printf("burst decode, ns per 8 words\n");
+    printf("  signs         checked  unchecked\n");
+    TimeBursts("steady", steady, order);
+    TimeBursts("random", random, order);
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const char* path   = argc > 1 ? argv[1] : "adc_frames.txt";
+    const auto  frames = LoadFrames(path);
+
+    const char* kNames[]
+        = {"full_scale", "bad_sgn", "misaligned", "unscanned", "stream_slip"};
+    for(const char* name : kNames)
+    {
+        if(frames.count(name) == 0)
+        {
+            printf("FAIL  %s: not in %s\n", name, path);
+            return 1;
+        }
+    }
+
+    FullScale(frames.at("full_scale"));
+    BadSgn(frames.at("bad_sgn"));
+    Misaligned(frames.at("misaligned"));
+    Unscanned(frames.at("unscanned"));
+    StreamSlip(frames.at("stream_slip"));
+    Timing(frames.at("full_scale"));
+
+    printf("%s\n", failures == 0 ? "all frames decode" : "frames failed");
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,184 @@
+#pragma once
+
+#include <chrono>
+#include <complex>
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+/**
+    Shared by the host benchmarks: a bank of wave tables laid out the way
+    LoadWavetables() leaves them, a timer, and a spectrum for alias figures.
+
+    Timings are from the host, not the Daisy. They compare one option with
+    another in the same build; they are not a budget for the firmware.
+*/
+namespace bench
+{
+constexpr size_t kWaveSize  = 2048; // the default WAVE_SAMPLES
+constexpr size_t kBankWaves = 512;  // 8 pages of 8x8
+constexpr float  kRate      = 48000.0f;
+constexpr size_t kBlockSize = 24; // kAudioBlockSize
+
+// One wave of a bank: sample at `phase` (0 to 1) of wave `wave`
+typedef float (*WaveShape)(size_t wave, float phase);
+
+inline float SineShape(size_t wave, float phase)
+{
+    return sinf(2.0f * static_cast<float>(M_PI) * phase);
+}
+
+class WaveBank
+{
+  public:
+    explicit WaveBank(WaveShape shape)
+    : samples_(kBankWaves * kWaveSize)
+    {
+        for(size_t w = 0; w < kBankWaves; w++)
+        {
+            waves_[w] = &samples_[w * kWaveSize];
+            for(size_t i = 0; i < kWaveSize; i++)
+            {
+                waves_[w][i]
+                    = shape(w, static_cast<float>(i) / kWaveSize);
+            }
+        }
+    }
+
+    float** Waves() { return waves_; }
+
+  private:
+    std::vector<float> samples_;
+    float*             waves_[kBankWaves];
+};
+
+// Wall time and, on x86, time-stamp counter ticks, which run at about the
+// nominal core clock
+class Stopwatch
+{
+  public:
+    void Start()
+    {
+        start_  = std::chrono::steady_clock::now();
+        cycles_ = ReadCycles();
+    }
+
+    // Per item, over `count` items since Start()
+    double Ns(size_t count) const
+    {
+        const std::chrono::duration<double, std::nano> elapsed
+            = std::chrono::steady_clock::now() - start_;
+        return elapsed.count() / static_cast<double>(count);
+    }
+    double Cycles(size_t count) const
+    {
+        return static_cast<double>(ReadCycles() - cycles_)
+               / static_cast<double>(count);
+    }
+
+  private:
+    static uint64_t ReadCycles()
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        return 0;
+#endif
+    }
+
+    std::chrono::steady_clock::time_point start_;
+    uint64_t                              cycles_;
+};
+
+// In-place radix-2 FFT; x.size() must be a power of two
+inline void Fft(std::vector<std::complex<double>>& x)
+{
+    const size_t n = x.size();
+    for(size_t i = 1, j = 0; i < n; i++)
+    {
+        size_t bit = n >> 1;
+        for(; j & bit; bit >>= 1)
+        {
+            j ^= bit;
+        }
+        j ^= bit;
+        if(i < j)
+        {
+            std::swap(x[i], x[j]);
+        }
+    }
+    for(size_t size = 2; size <= n; size <<= 1)
+    {
+        const std::complex<double> step
+            = std::polar(1.0, -2.0 * M_PI / static_cast<double>(size));
+        for(size_t start = 0; start < n; start += size)
+        {
+            std::complex<double> w = 1.0;
+            for(size_t k = 0; k < size / 2; k++)
+            {
+                const std::complex<double> a = x[start + k];
+                const std::complex<double> b = x[start + k + size / 2] * w;
+                x[start + k]                 = a + b;
+                x[start + k + size / 2]      = a - b;
+                w *= step;
+            }
+        }
+    }
+}
+
+/**
+    Power on the harmonics of `fundamental` over the power everywhere else,
+    20 Hz to 20 kHz, in dB. Takes the last power of two samples of `y`, past
+    any start-up transient. A 4-term Blackman-Harris window keeps the
+    leakage of strong harmonics under -90 dB; it spreads each partial over
+    a few bins, which all count as that partial.
+*/
+inline double AliasRejectionDb(const std::vector<float>& y,
+                               double                    fundamental,
+                               double                    rate)
+{
+    size_t n = 1;
+    while(n * 2 <= y.size())
+    {
+        n *= 2;
+    }
+    const size_t first = y.size() - n;
+
+    std::vector<std::complex<double>> spectrum(n);
+    for(size_t k = 0; k < n; k++)
+    {
+        const double x      = 2.0 * M_PI * k / n;
+        const double window = 0.35875 - 0.48829 * cos(x) + 0.14128 * cos(2 * x)
+                              - 0.01168 * cos(3 * x);
+        spectrum[k] = window * y[first + k];
+    }
+    Fft(spectrum);
+
+    const double bin_hz    = rate / static_cast<double>(n);
+    double       harmonics = 0.0;
+    double       aliases   = 0.0;
+    for(size_t bin = static_cast<size_t>(20.0 / bin_hz);
+        bin < static_cast<size_t>(20000.0 / bin_hz);
+        bin++)
+    {
+        const double hz      = bin * bin_hz;
+        const double nearest = fundamental * floor(hz / fundamental + 0.5);
+        const double power   = std::norm(spectrum[bin]);
+        if(fabs(hz - nearest) <= 6.0 * bin_hz)
+        {
+            harmonics += power;
+        }
+        else
+        {
+            aliases += power;
+        }
+    }
+    return 10.0 * log10(harmonics / aliases);
+}
+
+} // namespace bench
@@ -0,0 +1,220 @@
+#include <algorithm>
+#include <stdio.h>
+
+#include "wavetable_oscillator.h"
+
+#include "bench/bench.h"
+
+using namespace fourseas;
+
+/**
+    LFO-mode decimation (SetDecimation): cost per output sample, and how far
+    the decimated output strays from the full-rate one, for an LFO at a few
+    rates. Then whether phase modulation keeps its depth when decimated.
+    The firmware uses 8 on the full oscillators and 16 on the basic ones
+    (kLfoDecimation).
+*/
+namespace
+{
+constexpr size_t kSeconds = 4;
+constexpr size_t kSamples = kSeconds * static_cast<size_t>(bench::kRate);
+
+// The parameter ramps and the first interpolated points are done by here
+constexpr size_t kSettle = 480;
+
+// PHASE_MOD by a steady input: the offset stays in the phase, so it moves
+// the frequency, here by about 2.9 Hz. The phase runs down, so that is
+// towards 0 Hz; much more and the LFO would turn round.
+constexpr float kPmInput  = 0.0025f;
+constexpr float kPmAmount = 0.2f;
+
+// A sine with some of its 3rd harmonic, more of it further into the bank
+float LfoShape(size_t wave, float phase)
+{
+    const float depth = static_cast<float>(wave) / bench::kBankWaves;
+    const float w     = 2.0f * static_cast<float>(M_PI) * phase;
+    return sinf(w) + depth * sinf(3.0f * w) / 3.0f;
+}
+
+struct Result
+{
+    double ns;
+    double cycles;
+};
+
+template <typename Oscillator>
+Result Render(float**             waves,
+              float               hz,
+              size_t              factor,
+              std::vector<float>& out,
+              bool                pm = false)
+{
+    Oscillator osc;
+    osc.Init(waves);
+    osc.SetSampleRate(bench::kRate);
+    osc.SetDecimation(factor);
+
+    CvRamps cv{};
+    std::fill(&cv.fm_ratio[0], &cv.fm_ratio[kMaxAudioBlockSize], 1.0f);
+
+    float silence[bench::kBlockSize] = {};
+    float mod[bench::kBlockSize];
+    std::fill(&mod[0], &mod[bench::kBlockSize], pm ? kPmInput : 0.0f);
+
+    OscillatorParams params;
+    params.interpolate = false;
+    params.mod_state   = AppState::MOD_STATES::PHASE_MOD;
+    params.mod_input   = mod;
+    params.sync_input  = silence;
+
+    const ParamValues target
+        = {hz / bench::kRate, 2.5f, 1.5f, 0.5f, pm ? kPmAmount : 0.0f};
+
+    out.resize(kSamples);
+    bench::Stopwatch watch;
+    watch.Start();
+    for(size_t i = 0; i < kSamples; i += bench::kBlockSize)
+    {
+        osc.Update(target, bench::kBlockSize);
+        osc.Render(params, cv, &out[i], bench::kBlockSize);
+    }
+    return {watch.Ns(kSamples), watch.Cycles(kSamples)};
+}
+
+/**
+    Peak difference between `out` and `full` once both have settled. The
+    decimated output lags by about (factor + 1) / 2 samples, the delay of
+    the linear interpolation, give or take the sync delay line that only
+    the full-rate path has. Every half-sample lag from -1 to factor + 1 is
+    tried and the best one kept.
+*/
+float MaxError(const std::vector<float>& out,
+               const std::vector<float>& full,
+               size_t                    factor)
+{
+    const int32_t max_half = 2 * static_cast<int32_t>(factor) + 2;
+
+    float best = 1e9f;
+    for(int32_t half = -2; half <= max_half; half++)
+    {
+        // Halves round towards minus infinity on both sides
+        const int32_t early = half >= 0 ? half / 2 : -((1 - half) / 2);
+        const int32_t late  = half >= 0 ? (half + 1) / 2 : half / 2;
+
+        float worst = 0.0f;
+        for(size_t i = kSettle; i + 1 < out.size(); i++)
+        {
+            const float reference
+                = 0.5f * (full[i - early] + full[i - late]);
+            worst = std::max(worst, fabsf(out[i] - reference));
+        }
+        best = std::min(best, worst);
+    }
+    return best;
+}
+
+// Cycles per second, from the first to the last rising zero crossing
+double Frequency(const std::vector<float>& out)
+{
+    double first = -1.0;
+    double last  = -1.0;
+    size_t count = 0;
+    for(size_t i = kSettle; i + 1 < out.size(); i++)
+    {
+        if(out[i] < 0.0f && out[i + 1] >= 0.0f)
+        {
+            last = i + out[i] / (out[i] - out[i + 1]);
+            first = first < 0.0 ? last : first;
+            count++;
+        }
+    }
+    return count > 1 ? (count - 1) * bench::kRate / (last - first) : 0.0;
+}
+
+/**
+    The frequency PHASE_MOD adds at each factor, over what it adds at full
+    rate. 1 is the same depth.
+*/
+template <typename Oscillator>
+void PmDepth(float** waves)
+{
+    static constexpr float  kHz        = bench::kRate / 8192.0f;
+    static constexpr size_t kFactors[] = {1, 2, 4, 8, 16, 32};
+
+    std::vector<float> out;
+    double             full_shift = 0.0;
+
+    printf("phase modulation depth, %.2f Hz moved by a steady input\n", kHz);
+    printf("  factor  shift Hz  depth vs full rate\n");
+    for(size_t factor : kFactors)
+    {
+        Render<Oscillator>(waves, kHz, factor, out);
+        const double plain = Frequency(out);
+        Render<Oscillator>(waves, kHz, factor, out, true);
+        const double shift = Frequency(out) - plain;
+
+        full_shift = factor == 1 ? shift : full_shift;
+        printf("  %6zu  %8.3f  %18.4f\n", factor, shift, shift / full_shift);
+    }
+}
+
+template <typename Oscillator>
+void Sweep(const char* name, float** waves)
+{
+    // Powers of two in cycles per sample, so the phase sums are exact at
+    // every factor and the outputs don't drift apart
+    static constexpr float kLfoHz[] = {bench::kRate / 65536.0f,
+                                       bench::kRate / 8192.0f,
+                                       bench::kRate / 1024.0f};
+    static constexpr size_t kFactors[] = {1, 2, 4, 8, 16, 32};
+
+    printf("%s\n", name);
+    printf("  factor  ns/sample  cycles/sample  max error at");
+    for(float hz : kLfoHz)
+    {
+        printf(" %5.2f Hz", hz);
+    }
+    printf("\n");
+
+    std::vector<float> full[3];
+    for(size_t j = 0; j < 3; j++)
+    {
+        Render<Oscillator>(waves, kLfoHz[j], 1, full[j]);
+    }
+
+    for(size_t factor : kFactors)
+    {
+        std::vector<float> out;
+
+        // Best of a few runs, the host is not idle
+        Result cost = Render<Oscillator>(waves, kLfoHz[1], factor, out);
+        for(size_t run = 1; run < 5; run++)
+        {
+            const Result again
+                = Render<Oscillator>(waves, kLfoHz[1], factor, out);
+            cost = again.ns < cost.ns ? again : cost;
+        }
+        printf("  %6zu  %9.2f  %13.1f  %12s", factor, cost.ns, cost.cycles, "");
+        for(size_t j = 0; j < 3; j++)
+        {
+            Render<Oscillator>(waves, kLfoHz[j], factor, out);
+            printf(" %8.5f", MaxError(out, full[j], factor));
+        }
+        printf("\n");
+    }
+}
+} // namespace
+
+int main()
+{
+    bench::WaveBank bank(LfoShape);
+
+    Sweep<WavetableOscillator<bench::kWaveSize, true, true>>(
+        "full oscillator (sync, modulation)", bank.Waves());
+    Sweep<WavetableOscillator<bench::kWaveSize, false, false>>(
+        "basic oscillator", bank.Waves());
+    printf("\n");
+
+    PmDepth<WavetableOscillator<bench::kWaveSize, true, true>>(bank.Waves());
+    return 0;
+}
@@ -0,0 +1,149 @@
+#include <algorithm>
+#include <stdio.h>
+
+#include "wavetable_oscillator.h"
+
+#include "bench/bench.h"
+
+using namespace fourseas;
+
+/**
+    Audio-rate FM (EXP_FM, LINEAR_FM): what it adds per sample over the
+    plain render, and the accuracy and cost of FastExp2() against exp2f().
+*/
+namespace
+{
+constexpr size_t kSamples = 2000 * bench::kBlockSize;
+
+typedef WavetableOscillator<bench::kWaveSize, true, true> Oscillator;
+
+struct Result
+{
+    double ns;
+    double cycles;
+};
+
+// Best of a few runs, the host is not idle
+Result Render(float** waves, uint8_t mode, float amount)
+{
+    std::vector<float> mod(kSamples);
+    for(size_t i = 0; i < kSamples; i++)
+    {
+        mod[i] = static_cast<float>(sin(2.0 * M_PI * 331.0 * i / bench::kRate));
+    }
+
+    CvRamps cv{};
+    std::fill(&cv.fm_ratio[0], &cv.fm_ratio[kMaxAudioBlockSize], 1.0f);
+
+    float             silence[bench::kBlockSize] = {};
+    const ParamValues target
+        = {440.0f / bench::kRate, 2.5f, 1.5f, 0.5f, amount};
+
+    std::vector<float> out(kSamples);
+    Result             best = {1e9, 0.0};
+    for(size_t run = 0; run < 5; run++)
+    {
+        Oscillator osc;
+        osc.Init(waves);
+        osc.SetSampleRate(bench::kRate);
+
+        bench::Stopwatch watch;
+        watch.Start();
+        for(size_t i = 0; i < kSamples; i += bench::kBlockSize)
+        {
+            OscillatorParams params;
+            params.interpolate = false;
+            params.mod_state   = mode;
+            params.mod_input   = &mod[i];
+            params.sync_input  = silence;
+
+            osc.Update(target, bench::kBlockSize);
+            osc.Render(params, cv, &out[i], bench::kBlockSize);
+        }
+        if(watch.Ns(kSamples) < best.ns)
+        {
+            best = {watch.Ns(kSamples), watch.Cycles(kSamples)};
+        }
+    }
+    return best;
+}
+
+// Keeps the compiler from dropping the loops below
+volatile float sink;
+
+void Exp2()
+{
+    static constexpr size_t kCalls = 1 << 22;
+
+    // The FM range: kExpFmOctaves either way, and a margin
+    double worst_cents = 0.0;
+    for(int32_t i = -(1 << 20); i <= (1 << 20); i++)
+    {
+        const float  x     = 8.0f * static_cast<float>(i) / (1 << 20);
+        const double ratio = FastExp2(x) / exp2(static_cast<double>(x));
+        worst_cents        = std::max(worst_cents, fabs(1200.0 * log2(ratio)));
+    }
+
+    std::vector<float> x(kCalls);
+    for(size_t i = 0; i < kCalls; i++)
+    {
+        x[i] = 8.0f * static_cast<float>(i) / kCalls - 4.0f;
+    }
+
+    std::vector<float> y(kCalls);
+    bench::Stopwatch   watch;
+    watch.Start();
+    for(size_t i = 0; i < kCalls; i++)
+    {
+        y[i] = FastExp2(x[i]);
+    }
+    const double fast_ns     = watch.Ns(kCalls);
+    const double fast_cycles = watch.Cycles(kCalls);
+    sink                     = y[kCalls / 3];
+
+    watch.Start();
+    for(size_t i = 0; i < kCalls; i++)
+    {
+        y[i] = exp2f(x[i]);
+    }
+    const double libm_ns     = watch.Ns(kCalls);
+    const double libm_cycles = watch.Cycles(kCalls);
+    sink                     = y[kCalls / 3];
+
+    printf("FastExp2 over +-8 octaves: worst error %.3f cents\n", worst_cents);
+    printf("  FastExp2  %6.2f ns  %6.1f cycles per call\n",
+           fast_ns,
+           fast_cycles);
+    printf("  exp2f     %6.2f ns  %6.1f cycles per call\n",
+           libm_ns,
+           libm_cycles);
+}
+} // namespace
+
+int main()
+{
+    bench::WaveBank bank(bench::SineShape);
+
+    // No modulation at all: PHASE_MOD with the amount in its dead zone
+    const Result plain
+        = Render(bank.Waves(), AppState::MOD_STATES::PHASE_MOD, 0.0f);
+    const Result exponential
+        = Render(bank.Waves(), AppState::MOD_STATES::EXP_FM, 1.0f);
+    const Result linear
+        = Render(bank.Waves(), AppState::MOD_STATES::LINEAR_FM, 1.0f);
+
+    printf("mode       ns/sample  cycles/sample  added ns/sample\n");
+    printf("none       %9.2f  %13.1f\n", plain.ns, plain.cycles);
+    printf("EXP_FM     %9.2f  %13.1f  %15.2f\n",
+           exponential.ns,
+           exponential.cycles,
+           exponential.ns - plain.ns);
+    printf("LINEAR_FM  %9.2f  %13.1f  %15.2f\n",
+           linear.ns,
+           linear.cycles,
+           linear.ns - plain.ns);
+    printf("\n");
+
+    Exp2();
+    return 0;
+}
@@ -0,0 +1,166 @@
+#include <algorithm>
+#include <stdio.h>
+
+#include "wavetable_oscillator.h"
+
+#include "bench/bench.h"
+
+using namespace fourseas;
+
+/**
+    Phase interpolation policies (src/phase_interpolation.h): SNR of one
+    read of a single-harmonic table against the exact value, and what an
+    oscillator built on each policy costs to render. The build picks the
+    policy with PHASE_INTERP.
+*/
+namespace
+{
+// Harmonics of the test tables: 2048, 32 and 8 samples per cycle
+constexpr size_t kHarmonics[] = {1, 64, 256};
+
+struct TableSample
+{
+    const float* table;
+
+    inline float operator()(int32_t index) const
+    {
+        return table[index & (bench::kWaveSize - 1)];
+    }
+};
+
+template <typename Policy>
+double SnrDb(size_t harmonic)
+{
+    static constexpr size_t kReads = 1 << 20;
+
+    std::vector<float> table(bench::kWaveSize);
+    for(size_t i = 0; i < bench::kWaveSize; i++)
+    {
+        table[i] = static_cast<float>(
+            sin(2.0 * M_PI * harmonic * i / bench::kWaveSize));
+    }
+
+    // Phases spread evenly over the table, between every pair of samples
+    double signal = 0.0;
+    double noise  = 0.0;
+    for(size_t i = 0; i < kReads; i++)
+    {
+        const double  position   = 0.61803398875 * i * bench::kWaveSize;
+        const double  wrapped    = fmod(position, bench::kWaveSize);
+        const int32_t integral   = static_cast<int32_t>(wrapped);
+        const float   fractional = static_cast<float>(wrapped - integral);
+
+        const double exact
+            = sin(2.0 * M_PI * harmonic * wrapped / bench::kWaveSize);
+        const double read
+            = Policy::Read(TableSample{table.data()}, integral, fractional);
+        signal += exact * exact;
+        noise += (read - exact) * (read - exact);
+    }
+    return 10.0 * log10(signal / noise);
+}
+
+struct Result
+{
+    double ns;
+    double cycles;
+};
+
+/**
+    Per sample, best of a few runs, with the morph position held still
+    (blend cache: one wave read through the policy) and moving through the
+    bank (a read per blended corner)
+*/
+template <typename Policy>
+void Render(float** waves, Result* still_cost, Result* moving_cost)
+{
+    typedef WavetableOscillator<bench::kWaveSize, false, false, Policy>
+        Oscillator;
+
+    static constexpr size_t kBlocks  = 2000;
+    static constexpr size_t kSamples = kBlocks * bench::kBlockSize;
+
+    CvRamps still{};
+    std::fill(&still.fm_ratio[0], &still.fm_ratio[kMaxAudioBlockSize], 1.0f);
+
+    std::vector<CvRamps> moving(kBlocks, still);
+    for(size_t b = 0; b < kBlocks; b++)
+    {
+        for(size_t j = 0; j < bench::kBlockSize; j++)
+        {
+            const float t
+                = static_cast<float>(b * bench::kBlockSize + j) / bench::kRate;
+            const float w  = 2.0f * static_cast<float>(M_PI) * t;
+            moving[b].x[j] = 3.5f + 3.49f * sinf(1.3f * w);
+            moving[b].y[j] = 3.5f + 3.49f * sinf(0.7f * w);
+            moving[b].z[j] = 3.5f + 3.49f * sinf(0.3f * w);
+        }
+    }
+
+    const ParamValues target = {220.0f / bench::kRate, 2.5f, 3.5f, 1.5f, 0.0f};
+
+    OscillatorParams params;
+    params.interpolate = true;
+
+    *still_cost  = {1e9, 0.0};
+    *moving_cost = {1e9, 0.0};
+    for(size_t run = 0; run < 5; run++)
+    {
+        for(bool move : {false, true})
+        {
+            Oscillator osc;
+            osc.Init(waves);
+            osc.SetSampleRate(bench::kRate);
+
+            float            out[bench::kBlockSize];
+            bench::Stopwatch watch;
+            watch.Start();
+            for(size_t b = 0; b < kBlocks; b++)
+            {
+                osc.Update(target, bench::kBlockSize);
+                osc.Render(
+                    params, move ? moving[b] : still, out, bench::kBlockSize);
+            }
+            Result* best = move ? moving_cost : still_cost;
+            if(watch.Ns(kSamples) < best->ns)
+            {
+                *best = {watch.Ns(kSamples), watch.Cycles(kSamples)};
+            }
+        }
+    }
+}
+
+template <typename Policy>
+void Report(const char* name, float** waves)
+{
+    Policy::Init();
+
+    Result still, moving;
+    Render<Policy>(waves, &still, &moving);
+
+    printf("%-8s  %4d", name, static_cast<int>(Policy::kTaps));
+    for(size_t harmonic : kHarmonics)
+    {
+        printf("  %8.1f dB", SnrDb<Policy>(harmonic));
+    }
+    printf("  %6.1f  %6.1f  %6.1f  %6.1f\n",
+           still.ns,
+           still.cycles,
+           moving.ns,
+           moving.cycles);
+}
+} // namespace
+
+int main()
+{
+    bench::WaveBank bank(bench::SineShape);
+
+    printf("                SNR at samples per cycle"
+           "              still           moving\n");
+    printf("policy    taps       2048          32           8"
+           "      ns  cycles      ns  cycles\n");
+    Report<LinearPhase>("Linear", bank.Waves());
+    Report<HermitePhase>("Hermite", bank.Waves());
+    Report<SincPhase>("Sinc", bank.Waves());
+    return 0;
+}
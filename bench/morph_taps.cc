@@ -0,0 +1,154 @@
+#include <algorithm>
+#include <stdio.h>
+
+#include "wavetable_oscillator.h"
+
+#include "bench/bench.h"
+
+using namespace fourseas;
+
+/**
+    The morph read's tap count (CornersAt): corner waves, and taps at each
+    phase interpolation, averaged over sweeps of the x/y/z positions with
+    wave interpolation off and on. Then what a moving sweep costs to render
+    either way.
+*/
+namespace
+{
+typedef WavetableOscillator<bench::kWaveSize, false, false> Oscillator;
+
+constexpr float kMaxPosition = 6.9999f;
+
+// Deterministic positions in [0, kMaxPosition]
+class Positions
+{
+  public:
+    Positions() : state_(0x12345678u) {}
+
+    float Next()
+    {
+        state_ = state_ * 1664525u + 1013904223u;
+        return kMaxPosition * static_cast<float>(state_ >> 8) / (1 << 24);
+    }
+
+  private:
+    uint32_t state_;
+};
+
+// Every axis anywhere
+double UniformCorners(bool interpolate)
+{
+    static constexpr size_t kPoints = 1 << 20;
+
+    Positions positions;
+    double    corners = 0.0;
+    for(size_t i = 0; i < kPoints; i++)
+    {
+        const float x = positions.Next();
+        const float y = positions.Next();
+        const float z = positions.Next();
+        corners += Oscillator::CornersAt(x, y, z, interpolate);
+    }
+    return corners / kPoints;
+}
+
+// One knob turned end to end, the other two left wherever they were
+double OneKnobCorners(bool interpolate)
+{
+    static constexpr size_t kRests = 256;
+    static constexpr size_t kSteps = 4096;
+
+    Positions positions;
+    double    corners = 0.0;
+    for(size_t rest = 0; rest < kRests; rest++)
+    {
+        const float y = positions.Next();
+        const float z = positions.Next();
+        for(size_t step = 0; step < kSteps; step++)
+        {
+            const float x = kMaxPosition * step / (kSteps - 1);
+            corners += Oscillator::CornersAt(x, y, z, interpolate);
+        }
+    }
+    return corners / (kRests * kSteps);
+}
+
+void PrintRow(const char* sweep, bool interpolate, double corners)
+{
+    printf("%-22s  %-6s  %7.3f  %6.2f  %7.2f  %5.2f\n",
+           sweep,
+           interpolate ? "on" : "off",
+           corners,
+           corners * LinearPhase::kTaps,
+           corners * HermitePhase::kTaps,
+           corners * SincPhase::kTaps);
+}
+
+// All three positions moving through their whole range, a few times a
+// second each, so the blend cache never settles
+double RenderNs(float** waves, bool interpolate)
+{
+    static constexpr size_t kBlocks  = 2000;
+    static constexpr size_t kSamples = kBlocks * bench::kBlockSize;
+
+    std::vector<CvRamps> cv(kBlocks);
+    for(size_t b = 0; b < kBlocks; b++)
+    {
+        std::fill(
+            &cv[b].fm_ratio[0], &cv[b].fm_ratio[kMaxAudioBlockSize], 1.0f);
+        for(size_t j = 0; j < bench::kBlockSize; j++)
+        {
+            const float t
+                = static_cast<float>(b * bench::kBlockSize + j) / bench::kRate;
+            const float w = 2.0f * static_cast<float>(M_PI) * t;
+            cv[b].x[j]    = 3.5f + 3.49f * sinf(1.3f * w);
+            cv[b].y[j]    = 3.5f + 3.49f * sinf(0.7f * w);
+            cv[b].z[j]    = 3.5f + 3.49f * sinf(0.3f * w);
+        }
+    }
+
+    const ParamValues target = {220.0f / bench::kRate, 0.0f, 0.0f, 0.0f, 0.0f};
+
+    double best = 1e9;
+    for(size_t run = 0; run < 5; run++)
+    {
+        Oscillator osc;
+        osc.Init(waves);
+        osc.SetSampleRate(bench::kRate);
+
+        OscillatorParams params;
+        params.interpolate = interpolate;
+
+        float            out[bench::kBlockSize];
+        bench::Stopwatch watch;
+        watch.Start();
+        for(size_t b = 0; b < kBlocks; b++)
+        {
+            osc.Update(target, bench::kBlockSize);
+            osc.Render(params, cv[b], out, bench::kBlockSize);
+        }
+        best = std::min(best, watch.Ns(kSamples));
+    }
+    return best;
+}
+} // namespace
+
+int main()
+{
+    printf("sweep                   interp  corners  "
+           "taps at Linear  Hermite  Sinc\n");
+    for(bool interpolate : {false, true})
+    {
+        PrintRow("x, y, z uniform", interpolate, UniformCorners(interpolate));
+        PrintRow("one knob, others rest",
+                 interpolate,
+                 OneKnobCorners(interpolate));
+    }
+    printf("\n");
+
+    bench::WaveBank bank(bench::SineShape);
+    printf("moving render, Linear: %.2f ns/sample off, %.2f ns/sample on\n",
+           RenderNs(bank.Waves(), false),
+           RenderNs(bank.Waves(), true));
+    return 0;
+}
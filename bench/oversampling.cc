@@ -0,0 +1,123 @@
+#include <algorithm>
+#include <stdio.h>
+
+#include "wavetable_oscillator.h"
+
+#include "bench/bench.h"
+
+using namespace fourseas;
+
+/**
+    Oversampling of the WAVESHAPING and XOR modes (SetOversampling): cost
+    per output sample and alias rejection at each factor. The firmware uses
+    2 (kModOversampling).
+
+    WAVESHAPING is driven by a full-scale sine on the mod input, XOR by a
+    sine wave table XORed with a steady mod input; either way the output
+    should only hold harmonics of the tone, and everything else is aliasing.
+*/
+namespace
+{
+// Whole blocks, and enough for a 65536-point spectrum
+constexpr size_t kSamples = (65536 / bench::kBlockSize + 1) * bench::kBlockSize;
+
+typedef WavetableOscillator<bench::kWaveSize, true, true> Oscillator;
+
+struct Result
+{
+    double ns;
+    double cycles;
+    double rejection_db;
+};
+
+Result Measure(float** waves, uint8_t mode, float tone_hz, size_t factor)
+{
+    std::vector<float> mod(kSamples);
+    for(size_t i = 0; i < kSamples; i++)
+    {
+        const double phase = tone_hz * static_cast<double>(i) / bench::kRate;
+        mod[i]             = mode == AppState::MOD_STATES::WAVESHAPING
+                                 ? static_cast<float>(sin(2.0 * M_PI * phase))
+                                 : 0.3f;
+    }
+
+    CvRamps cv{};
+    std::fill(&cv.fm_ratio[0], &cv.fm_ratio[kMaxAudioBlockSize], 1.0f);
+
+    float             silence[bench::kBlockSize] = {};
+    const ParamValues target
+        = {tone_hz / bench::kRate, 0.0f, 0.0f, 0.0f, 1.0f};
+
+    std::vector<float> out(kSamples);
+    Result             result = {1e9, 0.0, 0.0};
+    for(size_t run = 0; run < 5; run++)
+    {
+        Oscillator osc;
+        osc.Init(waves);
+        osc.SetSampleRate(bench::kRate);
+        osc.SetOversampling(factor);
+
+        bench::Stopwatch watch;
+        watch.Start();
+        for(size_t i = 0; i < kSamples; i += bench::kBlockSize)
+        {
+            OscillatorParams params;
+            params.interpolate = false;
+            params.mod_state   = mode;
+            params.mod_input   = &mod[i];
+            params.sync_input  = silence;
+
+            osc.Update(target, bench::kBlockSize);
+            osc.Render(params, cv, &out[i], bench::kBlockSize);
+        }
+
+        // Best of a few runs, the host is not idle
+        if(watch.Ns(kSamples) < result.ns)
+        {
+            result.ns     = watch.Ns(kSamples);
+            result.cycles = watch.Cycles(kSamples);
+        }
+    }
+    result.rejection_db
+        = bench::AliasRejectionDb(out, tone_hz, bench::kRate);
+    return result;
+}
+} // namespace
+
+int main()
+{
+    static constexpr size_t kFactors[] = {1, 2, 4};
+    static constexpr float  kTonesHz[] = {997.0f, 4001.0f};
+
+    bench::WaveBank bank(bench::SineShape);
+
+    const uint8_t     modes[] = {AppState::MOD_STATES::WAVESHAPING,
+                                 AppState::MOD_STATES::XOR};
+    const char* const names[] = {"WAVESHAPING", "XOR"};
+    for(size_t m = 0; m < 2; m++)
+    {
+        printf("%s\n", names[m]);
+        printf("  factor  ns/sample  cycles/sample  alias rejection at");
+        for(float hz : kTonesHz)
+        {
+            printf("  %4.0f Hz", hz);
+        }
+        printf("\n");
+
+        for(size_t factor : kFactors)
+        {
+            const Result low
+                = Measure(bank.Waves(), modes[m], kTonesHz[0], factor);
+            const Result high
+                = Measure(bank.Waves(), modes[m], kTonesHz[1], factor);
+            printf("  %6zu  %9.2f  %13.1f  %18s  %4.1f dB  %4.1f dB\n",
+                   factor,
+                   low.ns,
+                   low.cycles,
+                   "",
+                   low.rejection_db,
+                   high.rejection_db);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,187 @@
+#include <algorithm>
+#include <stdio.h>
+
+#include "wavetable_oscillator.h"
+
+#include "bench/bench.h"
+
+using namespace fourseas;
+
+/**
+    Oscillator sync (HARD, SOFT, FLIP): alias energy with the PolyBLEP
+    residuals at the edges, against the sync they replaced, which applied
+    the mode on the first sample after an edge. Then what the edges cost
+    per sample.
+*/
+namespace
+{
+constexpr size_t kBlocks  = 4096;
+constexpr size_t kSamples = kBlocks * bench::kBlockSize;
+
+constexpr float kSlaveHz = 1730.0f;
+constexpr float kSyncHz  = 440.0f;
+
+typedef WavetableOscillator<bench::kWaveSize, true, true> Oscillator;
+
+struct Result
+{
+    double ns;
+    double cycles;
+};
+
+// A sine on the sync input, so the detector has a slope to place the
+// edge on
+std::vector<float> SyncInput(float hz)
+{
+    std::vector<float> sync(kSamples);
+    for(size_t i = 0; i < kSamples; i++)
+    {
+        sync[i] = static_cast<float>(sin(2.0 * M_PI * hz * i / bench::kRate));
+    }
+    return sync;
+}
+
+// Best of a few runs, the host is not idle
+Result Render(float**                   waves,
+              uint8_t                   mode,
+              const std::vector<float>& sync,
+              std::vector<float>&       out)
+{
+    float            silence[bench::kBlockSize] = {};
+    OscillatorParams params;
+    params.interpolate = false;
+    params.mod_state   = AppState::MOD_STATES::PHASE_MOD;
+    params.mod_input   = silence;
+    params.sync_state  = mode;
+
+    CvRamps cv{};
+    std::fill(&cv.fm_ratio[0], &cv.fm_ratio[kMaxAudioBlockSize], 1.0f);
+
+    const ParamValues target
+        = {kSlaveHz / bench::kRate, 2.5f, 1.5f, 0.5f, 0.0f};
+
+    out.resize(kSamples);
+    Result best = {1e9, 0.0};
+    for(size_t run = 0; run < 5; run++)
+    {
+        Oscillator osc;
+        osc.Init(waves);
+        osc.SetSampleRate(bench::kRate);
+
+        bench::Stopwatch watch;
+        watch.Start();
+        for(size_t i = 0; i < kSamples; i += bench::kBlockSize)
+        {
+            params.sync_input = &sync[i];
+            osc.Update(target, bench::kBlockSize);
+            osc.Render(params, cv, &out[i], bench::kBlockSize);
+        }
+        if(watch.Ns(kSamples) < best.ns)
+        {
+            best = {watch.Ns(kSamples), watch.Cycles(kSamples)};
+        }
+    }
+    return best;
+}
+
+/**
+    The sync before the residuals, on the same sine: the phase steps on,
+    and on the first sample after an edge the mode is applied to it as it
+    stands
+*/
+std::vector<float> GridSync(uint8_t mode, const std::vector<float>& sync)
+{
+    const float f0 = kSlaveHz / bench::kRate;
+
+    SyncDetector detector;
+    detector.Init();
+    SyncEdges edges;
+
+    std::vector<float> out(kSamples);
+    float              phase   = 0.0f;
+    bool               flipped = false;
+    for(size_t b = 0; b < kSamples; b += bench::kBlockSize)
+    {
+        detector.Process(&sync[b], bench::kBlockSize, &edges);
+
+        size_t e = 0;
+        for(size_t i = 0; i < bench::kBlockSize; i++)
+        {
+            phase += flipped ? f0 : -f0;
+            phase -= floorf(phase);
+
+            if(e < edges.count && edges.index[e] == i)
+            {
+                e++;
+                if(mode == AppState::SYNC_MODES::HARD
+                   || (mode == AppState::SYNC_MODES::SOFT && phase <= 0.25f))
+                {
+                    phase = 0.0f;
+                }
+                else if(mode == AppState::SYNC_MODES::FLIP)
+                {
+                    flipped = !flipped;
+                }
+            }
+            out[b + i] = sinf(2.0f * static_cast<float>(M_PI) * phase);
+        }
+    }
+    return out;
+}
+
+void Report(const char* name, uint8_t mode, float** waves)
+{
+    const std::vector<float> sync = SyncInput(kSyncHz);
+
+    // FLIP turns the slave round on every edge, so it repeats every other
+    const double fundamental
+        = mode == AppState::SYNC_MODES::FLIP ? kSyncHz / 2.0 : kSyncHz;
+
+    std::vector<float> out;
+    Render(waves, mode, sync, out);
+
+    const std::vector<float> grid = GridSync(mode, sync);
+
+    printf("%-4s  %12.1f dB  %12.1f dB\n",
+           name,
+           -bench::AliasRejectionDb(grid, fundamental, bench::kRate),
+           -bench::AliasRejectionDb(out, fundamental, bench::kRate));
+}
+} // namespace
+
+int main()
+{
+    // Every wave the same sine, so the morph position makes no difference
+    // and the grid model reads the same wave
+    bench::WaveBank bank(bench::SineShape);
+
+    printf("alias energy over the harmonics, %.0f Hz synced at %.0f Hz\n",
+           kSlaveHz,
+           kSyncHz);
+    printf("mode       on the grid  with residuals\n");
+    Report("HARD", AppState::SYNC_MODES::HARD, bank.Waves());
+    Report("SOFT", AppState::SYNC_MODES::SOFT, bank.Waves());
+    Report("FLIP", AppState::SYNC_MODES::FLIP, bank.Waves());
+    printf("\n");
+
+    // Residuals are worked out on edges only
+    const std::vector<float> no_edges = SyncInput(0.0f);
+    const std::vector<float> edges    = SyncInput(kSyncHz);
+
+    std::vector<float> out;
+
+    const Result free_running
+        = Render(bank.Waves(), AppState::SYNC_MODES::HARD, no_edges, out);
+    const Result synced
+        = Render(bank.Waves(), AppState::SYNC_MODES::HARD, edges, out);
+
+    printf("HARD cost     ns/sample  cycles/sample\n");
+    printf("no edges      %9.2f  %13.1f\n",
+           free_running.ns,
+           free_running.cycles);
+    printf("%3.0f Hz sync   %9.2f  %13.1f\n",
+           kSyncHz,
+           synced.ns,
+           synced.cycles);
+    return 0;
+}
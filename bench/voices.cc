@@ -0,0 +1,126 @@
+#include <algorithm>
+#include <stdio.h>
+
+#include "wavetable_oscillator.h"
+
+#include "bench/bench.h"
+
+using namespace fourseas;
+
+/**
+    Unison / chord voices (SetVoices): what one full oscillator costs per
+    output sample at each voice count the UI offers, with the morph held
+    still and moving through the bank. The voices share the morph, so only
+    their phase steps and wave reads are added.
+*/
+namespace
+{
+constexpr size_t kBlocks  = 2000;
+constexpr size_t kSamples = kBlocks * bench::kBlockSize;
+
+constexpr size_t kVoiceCounts[] = {1, 2, 3, 4, 6, 8};
+
+typedef WavetableOscillator<bench::kWaveSize, true, true> Oscillator;
+
+struct Result
+{
+    double ns;
+    double cycles;
+};
+
+// Four chord ratios, then the same an octave up, each a little detuned
+// the way Ui::UpdateVoices() does it. The ratios don't change the cost.
+VoiceSpread Spread(size_t count)
+{
+    static constexpr float kChord[4] = {1.0f, 1.25f, 1.5f, 1.875f};
+
+    VoiceSpread spread;
+    spread.count = count;
+    for(size_t v = 0; v < count; v++)
+    {
+        const float detune = v == 0 ? 1.0f : (v & 1 ? 1.004f : 0.996f);
+        spread.ratio[v]    = kChord[v % 4] * (v < 4 ? 1.0f : 2.0f) * detune;
+    }
+    return spread;
+}
+
+// Per sample, best of a few runs
+void Render(float** waves, size_t count, Result* still, Result* moving)
+{
+    CvRamps steady{};
+    std::fill(
+        &steady.fm_ratio[0], &steady.fm_ratio[kMaxAudioBlockSize], 1.0f);
+
+    std::vector<CvRamps> sweep(kBlocks, steady);
+    for(size_t b = 0; b < kBlocks; b++)
+    {
+        for(size_t j = 0; j < bench::kBlockSize; j++)
+        {
+            const float t
+                = static_cast<float>(b * bench::kBlockSize + j) / bench::kRate;
+            const float w = 2.0f * static_cast<float>(M_PI) * t;
+            sweep[b].x[j] = 3.5f + 3.49f * sinf(1.3f * w);
+            sweep[b].y[j] = 3.5f + 3.49f * sinf(0.7f * w);
+            sweep[b].z[j] = 3.5f + 3.49f * sinf(0.3f * w);
+        }
+    }
+
+    float            silence[bench::kBlockSize] = {};
+    OscillatorParams params;
+    params.interpolate = false;
+    params.mod_state   = AppState::MOD_STATES::PHASE_MOD;
+    params.mod_input   = silence;
+    params.sync_input  = silence;
+
+    const ParamValues target = {220.0f / bench::kRate, 2.5f, 3.5f, 1.5f, 0.0f};
+    const VoiceSpread spread = Spread(count);
+
+    *still  = {1e9, 0.0};
+    *moving = {1e9, 0.0};
+    for(size_t run = 0; run < 5; run++)
+    {
+        for(bool move : {false, true})
+        {
+            Oscillator osc;
+            osc.Init(waves);
+            osc.SetSampleRate(bench::kRate);
+            osc.SetVoices(spread, kMaxVoices);
+
+            float            out[bench::kBlockSize];
+            bench::Stopwatch watch;
+            watch.Start();
+            for(size_t b = 0; b < kBlocks; b++)
+            {
+                osc.Update(target, bench::kBlockSize);
+                osc.Render(
+                    params, move ? sweep[b] : steady, out, bench::kBlockSize);
+            }
+            Result* best = move ? moving : still;
+            if(watch.Ns(kSamples) < best->ns)
+            {
+                *best = {watch.Ns(kSamples), watch.Cycles(kSamples)};
+            }
+        }
+    }
+}
+} // namespace
+
+int main()
+{
+    bench::WaveBank bank(bench::SineShape);
+
+    printf("              still           moving\n");
+    printf("voices      ns  cycles      ns  cycles\n");
+    for(size_t count : kVoiceCounts)
+    {
+        Result still, moving;
+        Render(bank.Waves(), count, &still, &moving);
+        printf("%6zu  %6.1f  %6.1f  %6.1f  %6.1f\n",
+               count,
+               still.ns,
+               still.cycles,
+               moving.ns,
+               moving.cycles);
+    }
+    return 0;
+}
@@ -0,0 +1,163 @@
+#include "src/adc_scheduler.h"
+
+using namespace fourseas;
+
+void AdcScheduler::Init(AdcMCP3564R* adc, const Config& config)
+{
+    adc_         = adc;
+    config_      = config;
+    calibrating_ = false;
+
+    const AdcMCP3564R::Registers& regs = adc_->GetShadow();
+    osr_ = static_cast<AdcMCP3564R::OSRSel>((regs.config[1] >> 2) & 0xf);
+    channels_ = regs.scan[1] << 8 | regs.scan[2];
+
+    const AdcMCP3564R::ScanTiming timing = adc_->GetScanTiming();
+    window_start_ms_ = 0;
+    last_busy_ticks_ = timing.busy_ticks;
+    settling_        = true;
+    load_            = 0.0f;
+
+    full_scan_   = false;
+    scan_set_ms_ = 0;
+    scanned_     = 0;
+}
+
+void AdcScheduler::Process(uint32_t now_ms)
+{
+    if(calibrating_)
+    {
+        return;
+    }
+
+    if(now_ms - window_start_ms_ >= kWindowMs)
+    {
+        Evaluate(now_ms);
+    }
+
+    if(config_.fast_channels != 0)
+    {
+        UpdateScanSet(now_ms);
+    }
+}
+
+void AdcScheduler::Evaluate(uint32_t now_ms)
+{
+    const AdcMCP3564R::ScanTiming timing = adc_->GetScanTiming();
+
+    const float window_s = static_cast<float>(now_ms - window_start_ms_)
+                           * 0.001f;
+    const float busy_s = static_cast<float>(timing.busy_ticks
+                                            - last_busy_ticks_)
+                         / static_cast<float>(daisy::System::GetTickFreq());
+    load_ = busy_s / window_s;
+
+    window_start_ms_ = now_ms;
+    last_busy_ticks_ = timing.busy_ticks;
+
+    // The window after a change saw both settings
+    if(settling_)
+    {
+        settling_ = false;
+        return;
+    }
+
+    AdcMCP3564R::OSRSel osr = osr_;
+    if(load_ > config_.cpu_budget && osr < config_.max_osr)
+    {
+        osr = static_cast<AdcMCP3564R::OSRSel>(osr + 1);
+    }
+    else if(load_ * 2.0f < config_.cpu_budget * kStepDownHeadroom
+            && osr > config_.min_osr)
+    {
+        osr = static_cast<AdcMCP3564R::OSRSel>(osr - 1);
+    }
+
+    if(osr != osr_)
+    {
+        Apply(osr, channels_);
+        settling_ = true;
+    }
+}
+
+/*
+    Fast channel mode. A full scan is asked for every kFullScanIntervalMs
+    and held until every channel has been read once (or it times out),
+    then the scan drops back to the fast channels.
+*/
+void AdcScheduler::UpdateScanSet(uint32_t now_ms)
+{
+    if(!full_scan_)
+    {
+        if(now_ms - scan_set_ms_ >= kFullScanIntervalMs)
+        {
+            adc_->TakeFreshChannels();
+            scanned_     = 0;
+            full_scan_   = true;
+            scan_set_ms_ = now_ms;
+            Apply(osr_, config_.all_channels);
+        }
+        return;
+    }
+
+    scanned_ |= adc_->TakeFreshChannels();
+    if(scanned_ == (config_.all_channels & 0xff)
+       || now_ms - scan_set_ms_ >= kFullScanTimeoutMs)
+    {
+        full_scan_   = false;
+        scan_set_ms_ = now_ms;
+        Apply(osr_, config_.fast_channels);
+    }
+}
+
+void AdcScheduler::BeginCalibration()
+{
+    calibrating_ = true;
+    adc_->Configure()
+        .SetOversamplingRatio(kCalibrationOsr)
+        .SetScanRegister(AdcMCP3564R::SCAN_DELAY_0, config_.all_channels)
+        .Commit();
+}
+
+void AdcScheduler::EndCalibration()
+{
+    calibrating_ = false;
+    settling_    = true;
+    Apply(osr_, channels_);
+}
+
+void AdcScheduler::Apply(AdcMCP3564R::OSRSel osr, uint16_t channels)
+{
+    if(adc_->Configure()
+           .SetOversamplingRatio(osr)
+           .SetScanRegister(AdcMCP3564R::SCAN_DELAY_0, channels)
+           .Commit()
+       == AdcMCP3564R::Result::OK)
+    {
+        osr_      = osr;
+        channels_ = channels;
+    }
+}
+
+uint32_t AdcScheduler::Ratio(AdcMCP3564R::OSRSel osr)
+{
+    static const uint32_t kRatios[] = {
+        32,
+        64,
+        128,
+        256,
+        512,
+        1024,
+        2048,
+        4096,
+        8192,
+        16384,
+        20480,
+        24576,
+        40960,
+        49152,
+        81920,
+        98304,
+    };
+    return kRatios[osr & 0xf];
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "src/drivers/MCP3564R.h"
+
+namespace fourseas
+{
+/**
+    Picks the MCP3564R oversampling ratio at run time.
+
+    Every window it reads how long the driver's interrupts ran and how fast
+    scans came in, then moves the OSR one step at a time: up when the
+    interrupts use more than the CPU budget, down when halving the OSR
+    (about twice the scans) would still leave 20% of the budget spare.
+    Lower OSR means fresher CVs at the cost of noise and interrupts.
+
+    Calibration gets its own high-OSR, all-channel settings for as long as
+    it runs.
+
+    Optionally, only `fast_channels` are scanned most of the time, with a
+    full scan every kFullScanIntervalMs for the others, so the channels
+    that move at audio-ish rates are read several times as often.
+*/
+class AdcScheduler
+{
+  public:
+    struct Config
+    {
+        float               cpu_budget    = 0.02f; // share of the CPU
+        AdcMCP3564R::OSRSel min_osr       = AdcMCP3564R::OSR_1024;
+        AdcMCP3564R::OSRSel max_osr       = AdcMCP3564R::OSR_4096;
+        uint16_t            all_channels  = 0xff;
+        uint16_t            fast_channels = 0; // 0: all channels every scan
+    };
+
+    AdcScheduler() {}
+    ~AdcScheduler() {}
+
+    /** Starts from whatever OSR the ADC is set to */
+    void Init(AdcMCP3564R* adc, const Config& config);
+
+    /** Call from the main loop; cheap unless something has to change */
+    void Process(uint32_t now_ms);
+
+    /** Low-noise settings until EndCalibration() */
+    void BeginCalibration();
+    void EndCalibration();
+
+    inline AdcMCP3564R::OSRSel Osr() const { return osr_; }
+
+    /** Share of the CPU the ADC interrupts took over the last window */
+    inline float Load() const { return load_; }
+
+    /** Oversampling ratio an OSRSel stands for */
+    static uint32_t Ratio(AdcMCP3564R::OSRSel osr);
+
+  private:
+    static constexpr uint32_t kWindowMs = 500;
+
+    static constexpr AdcMCP3564R::OSRSel kCalibrationOsr
+        = AdcMCP3564R::OSR_16384;
+
+    // Spare budget needed before stepping down, which doubles the load
+    static constexpr float kStepDownHeadroom = 0.8f;
+
+    // Fast channel mode: how often the slow channels are read, and how
+    // long a full scan may take before giving up on it
+    static constexpr uint32_t kFullScanIntervalMs = 20;
+    static constexpr uint32_t kFullScanTimeoutMs  = 5;
+
+    void Evaluate(uint32_t now_ms);
+    void UpdateScanSet(uint32_t now_ms);
+    void Apply(AdcMCP3564R::OSRSel osr, uint16_t channels);
+
+    AdcMCP3564R* adc_;
+    Config       config_;
+
+    AdcMCP3564R::OSRSel osr_;
+    uint16_t            channels_;
+    bool                calibrating_;
+
+    uint32_t window_start_ms_;
+    uint32_t last_busy_ticks_;
+    bool     settling_;
+    float    load_;
+
+    bool     full_scan_;
+    uint32_t scan_set_ms_;
+    uint8_t  scanned_;
+};
+
+} // namespace fourseas
@@ -3,11 +3,11 @@
 
 using namespace fourseas;
 
-void AnalogControl24::Init(uint32_t *adcptr,
-                           float     sr,
-                           bool      flip,
-                           bool      invert,
-                           float     slew_seconds)
+void AnalogControl24::Init(int32_t *adcptr,
+                           float    sr,
+                           bool     flip,
+                           bool     invert,
+                           float    slew_seconds)
 {
     val_        = 0.0f;
     raw_        = adcptr;
@@ -21,9 +21,9 @@ void AnalogControl24::Init(uint32_t *adcptr,
     slew_seconds_ = slew_seconds;
 }
 
-void AnalogControl24::InitBipolarCv(uint32_t *adcptr,
-                                    float     sr,
-                                    float     slew_seconds)
+void AnalogControl24::InitBipolarCv(int32_t *adcptr,
+                                    float    sr,
+                                    float    slew_seconds)
 {
     val_        = 0.0f;
     raw_        = adcptr;
@@ -37,15 +37,19 @@ void AnalogControl24::InitBipolarCv(uint32_t *adcptr,
 }
 
 float AnalogControl24::Process()
+{
+    float t = Normalize(*raw_);
+    val_ += coeff_ * (t - val_);
+    return val_;
+}
+
+float AnalogControl24::Normalize(int32_t raw) const
 {
     float t;
-    t = (float)*raw_
-        / 8388607.0f; // TODO: ensure this is correct and check sign bit
+    t = (float)raw / 8388607.0f; // signed, so overrange goes past 0 and 1
     if(flip_)
         t = 1.f - t;
-    t = (t - offset_) * scale_ * (invert_ ? -1.0f : 1.0f);
-    val_ += coeff_ * (t - val_);
-    return val_;
+    return (t - offset_) * scale_ * (invert_ ? -1.0f : 1.0f);
 }
 
 void AnalogControl24::SetSampleRate(float sample_rate)
@@ -18,11 +18,11 @@ class AnalogControl24
     \param invert determines whether the input is inverted (i.e. -1.f * input) or note before being processed.
     \param slew_seconds is the slew time in seconds that it takes for the control to change to a new value.
     */
-    void Init(uint32_t *adcptr,
-              float     sr,
-              bool      flip         = false,
-              bool      invert       = false,
-              float     slew_seconds = 0.002f);
+    void Init(int32_t *adcptr,
+              float    sr,
+              bool     flip         = false,
+              bool     invert       = false,
+              float    slew_seconds = 0.002f);
 
     /** 
     This Initializes the AnalogControl for a -5V to 5V inverted input
@@ -30,7 +30,7 @@ class AnalogControl24
     \param *adcptr Pointer to analog digital converter
     \param sr Audio engine sample rate
     */
-    void InitBipolarCv(uint32_t *adcptr, float sr, float slew_seconds = 0.002f);
+    void InitBipolarCv(int32_t *adcptr, float sr, float slew_seconds = 0.002f);
 
     /** 
     Filters, and transforms a raw ADC read into a normalized range.
@@ -40,6 +40,13 @@ class AnalogControl24
     */
     float Process();
 
+    /**
+    Applies the same flip/offset/scale transform as Process() to an arbitrary
+    raw reading, without touching the slew filter.
+    Used to convert buffered ADC frames that are newer or older than *raw_.
+    */
+    float Normalize(int32_t raw) const;
+
     /** Returns the current stored value, without reprocessing */
     inline float Value() const { return val_; }
 
@@ -55,8 +62,8 @@ class AnalogControl24
         coeff_ = val;
     }
 
-    /** Returns the raw unsigned 24-bit value from the ADC */
-    inline uint32_t GetRawValue() { return *raw_; }
+    /** Returns the raw signed 25-bit value from the ADC */
+    inline int32_t GetRawValue() { return *raw_; }
 
     /** Returns a normalized float value representing the current ADC value. */
     inline float GetRawFloat() { return (float)(*raw_) / 8388607.0f; }
@@ -77,11 +84,11 @@ class AnalogControl24
     float scale_, offset_;
 
   private:
-    uint32_t *raw_;
-    float     coeff_, samplerate_, val_;
-    bool      flip_;
-    bool      invert_;
-    bool      is_bipolar_;
-    float     slew_seconds_;
+    int32_t *raw_;
+    float    coeff_, samplerate_, val_;
+    bool     flip_;
+    bool     invert_;
+    bool     is_bipolar_;
+    float    slew_seconds_;
 };
 } // namespace fourseas
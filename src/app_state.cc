@@ -15,6 +15,7 @@ AppState AppState::Default()
     defaultState.lfo_state_2       = false;
     defaultState.sync_mode_1       = HARD;
     defaultState.sync_mode_2       = HARD;
+    defaultState.voices            = 1;
 
     return defaultState;
 }
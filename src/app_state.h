@@ -1,5 +1,7 @@
 #pragma once
 
+#include <stdint.h>
+
 namespace fourseas
 {
 class AppState
@@ -10,6 +12,8 @@ class AppState
         PHASE_MOD,
         WAVESHAPING,
         XOR,
+        EXP_FM,
+        LINEAR_FM,
 
         MOD_STATES_LAST,
     };
@@ -57,6 +61,7 @@ class AppState
     bool                 lfo_state_2;
     AppState::SYNC_MODES sync_mode_1;
     AppState::SYNC_MODES sync_mode_2;
+    uint8_t              voices; // stacked per output, 1 to kMaxVoices
 
     AppState() {}
     ~AppState() {}
@@ -75,7 +80,8 @@ inline bool operator==(const AppState& lhs, const AppState& rhs)
            && lhs.lfo_state_1 == rhs.lfo_state_1
            && lhs.lfo_state_2 == rhs.lfo_state_2
            && lhs.sync_mode_1 == rhs.sync_mode_1
-           && lhs.sync_mode_2 == rhs.sync_mode_2;
+           && lhs.sync_mode_2 == rhs.sync_mode_2
+           && lhs.voices == rhs.voices;
 }
 
 inline bool operator!=(const AppState& lhs, const AppState& rhs)
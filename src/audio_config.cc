@@ -0,0 +1,120 @@
+#include "audio_config.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+using namespace fourseas;
+
+AudioConfig AudioConfig::FromProfile(Profile profile)
+{
+    AudioConfig config;
+    config.pipelined = false;
+
+    switch(profile)
+    {
+        case LOW_LATENCY:
+        {
+            config.sample_rate = 48000.0f;
+            config.block_size  = 8;
+            break;
+        }
+        case HEADROOM:
+        {
+            config.sample_rate = 48000.0f;
+            config.block_size  = 96;
+            break;
+        }
+        case HIGH_RATE:
+        {
+            config.sample_rate = 96000.0f;
+            config.block_size  = 48;
+            break;
+        }
+        default:
+        {
+            config.sample_rate = kSampleRate;
+            config.block_size  = kAudioBlockSize;
+            break;
+        }
+    }
+
+    return config;
+}
+
+void AudioConfig::Parse(const char* text, size_t size)
+{
+    size_t start = 0;
+    for(size_t i = 0; i <= size; i++)
+    {
+        if(i == size || text[i] == '\n' || text[i] == '\r')
+        {
+            if(i > start)
+            {
+                ParseLine(&text[start], i - start);
+            }
+            start = i + 1;
+        }
+    }
+}
+
+bool AudioConfig::ParseLine(const char* line, size_t length)
+{
+    // Long enough for any key or value we understand
+    char buffer[32];
+    if(length >= sizeof(buffer))
+    {
+        return false;
+    }
+    memcpy(buffer, line, length);
+    buffer[length] = '\0';
+
+    char* value = strchr(buffer, '=');
+    if(value == nullptr)
+    {
+        return false;
+    }
+    *value++ = '\0';
+
+    if(strcmp(buffer, "profile") == 0)
+    {
+        static const char* const kNames[PROFILE_LAST]
+            = {"default", "low_latency", "headroom", "high_rate"};
+
+        for(size_t i = 0; i < PROFILE_LAST; i++)
+        {
+            if(strcmp(value, kNames[i]) == 0)
+            {
+                *this = FromProfile(static_cast<Profile>(i));
+                return true;
+            }
+        }
+    }
+    else if(strcmp(buffer, "samplerate") == 0)
+    {
+        const long rate = strtol(value, nullptr, 10);
+        if(rate == 48000 || rate == 96000)
+        {
+            sample_rate = static_cast<float>(rate);
+            return true;
+        }
+    }
+    else if(strcmp(buffer, "blocksize") == 0)
+    {
+        const long size = strtol(value, nullptr, 10);
+        if(size >= static_cast<long>(kMinAudioBlockSize)
+           && size <= static_cast<long>(kMaxAudioBlockSize))
+        {
+            block_size = static_cast<size_t>(size);
+            return true;
+        }
+    }
+    else if(strcmp(buffer, "pipeline") == 0)
+    {
+        if(strcmp(value, "on") == 0 || strcmp(value, "off") == 0)
+        {
+            pipelined = value[1] == 'n';
+            return true;
+        }
+    }
+    return false;
+}
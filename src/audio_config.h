@@ -0,0 +1,62 @@
+#pragma once
+
+#include <stddef.h>
+
+#include "src/constants.h"
+
+namespace fourseas
+{
+/**
+    Sample rate and block size the firmware runs at, chosen once at boot.
+
+    Read from `audio.cfg` in the root of the SD card, one `key=value` per
+    line, e.g.
+
+        profile=low_latency
+        blocksize=16
+
+    `profile` picks one of the presets below, then `samplerate` (48000 or
+    96000) and `blocksize` (kMinAudioBlockSize to kMaxAudioBlockSize)
+    override it. `pipeline=on` renders one block ahead of the codec, see
+    BlockPipeline. Unknown keys and out-of-range values are ignored.
+*/
+struct AudioConfig
+{
+    enum Profile
+    {
+        DEFAULT,     // 48 kHz, 24 samples
+        LOW_LATENCY, // 48 kHz, 8 samples: least latency, most overhead
+        HEADROOM,    // 48 kHz, 96 samples: most CPU for voices
+        HIGH_RATE,   // 96 kHz, 48 samples
+
+        PROFILE_LAST,
+    };
+
+    float  sample_rate;
+    size_t block_size;
+    bool   pipelined;
+
+    static AudioConfig FromProfile(Profile profile);
+
+    /** Applies every line of a config file, `size` bytes long */
+    void Parse(const char* text, size_t size);
+
+    /** Applies one `key=value` line; false if it was not understood */
+    bool ParseLine(const char* line, size_t length);
+
+    /** Highest oscillator frequency, in cycles per sample */
+    inline float MaxFrequency() const { return kMaxFrequencyHz / sample_rate; }
+
+    inline size_t Samples(float seconds) const
+    {
+        return static_cast<size_t>(seconds * sample_rate + 0.5f);
+    }
+
+    inline size_t Blocks(float seconds) const
+    {
+        const size_t blocks = Samples(seconds) / block_size;
+        return blocks > 0 ? blocks : 1;
+    }
+};
+
+} // namespace fourseas
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "src/constants.h"
+#include "src/spsc_queue.h"
+
+namespace fourseas
+{
+/**
+    Lets the render run one block ahead of the audio callback.
+
+    The SAI DMA callback only calls Exchange(): it takes a block that has
+    already been rendered, copies it to the codec, and leaves its own
+    inputs in the same slot for the renderer. The renderer runs from a
+    lower-priority context and has two block periods to finish each block,
+    so other interrupts can hold it up for a whole block before anything
+    is heard. The cost is two blocks of extra latency: one for the slack
+    and one because the callback copies instead of rendering in place.
+
+    Slots pass between the two sides through a pair of SpscQueues, so each
+    side only ever touches a slot it owns.
+    \tparam channels number of input and of output channels
+*/
+template <size_t channels>
+class BlockPipeline
+{
+  public:
+    struct Block
+    {
+        float in[channels][kMaxAudioBlockSize];
+        float out[channels][kMaxAudioBlockSize];
+    };
+
+    BlockPipeline() {}
+    ~BlockPipeline() {}
+
+    /** Not real-time safe; call while audio is stopped */
+    void Init(size_t block_size)
+    {
+        block_size_ = block_size < kMaxAudioBlockSize ? block_size
+                                                      : kMaxAudioBlockSize;
+        underruns_  = 0;
+
+        Block* block;
+        while(to_render_.Pop(block)) {}
+        while(rendered_.Pop(block)) {}
+
+        // Both slots start out as rendered silence: one is played while
+        // the other is rendered.
+        for(size_t i = 0; i < kNumSlots; i++)
+        {
+            memset(&slots_[i], 0, sizeof(Block));
+            rendered_.Push(&slots_[i]);
+        }
+    }
+
+    /**
+    Callback side. Plays the oldest rendered block and queues `in` to be
+    rendered into it. On an underrun, plays silence, drops `in` and
+    returns false.
+    */
+    bool Exchange(const float* const* in, float** out)
+    {
+        Block* block;
+        if(!rendered_.Pop(block))
+        {
+            for(size_t c = 0; c < channels; c++)
+            {
+                memset(out[c], 0, block_size_ * sizeof(float));
+            }
+            underruns_++;
+            return false;
+        }
+
+        for(size_t c = 0; c < channels; c++)
+        {
+            memcpy(out[c], block->out[c], block_size_ * sizeof(float));
+            memcpy(block->in[c], in[c], block_size_ * sizeof(float));
+        }
+        to_render_.Push(block);
+        return true;
+    }
+
+    /** Render side. Next block waiting to be rendered, or nullptr. */
+    Block* Next()
+    {
+        Block* block;
+        return to_render_.Pop(block) ? block : nullptr;
+    }
+
+    /** Render side. Hands a block from Next() back to the callback. */
+    void Done(Block* block) { rendered_.Push(block); }
+
+    size_t BlockSize() const { return block_size_; }
+
+    /** Callbacks that found nothing rendered since Init() */
+    uint32_t Underruns() const { return underruns_; }
+
+  private:
+    static constexpr size_t kNumSlots = 2;
+
+    Block  slots_[kNumSlots];
+    size_t block_size_;
+
+    volatile uint32_t underruns_;
+
+    SpscQueue<Block*, 4> to_render_;
+    SpscQueue<Block*, 4> rendered_;
+};
+
+} // namespace fourseas
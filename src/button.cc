@@ -0,0 +1,105 @@
+#include <algorithm>
+
+#include "src/button.h"
+
+namespace fourseas
+{
+
+void Buttons::Init()
+{
+    // Counters rest at 3 and count down while a poll disagrees
+    count_low_  = 0xff;
+    count_high_ = 0xff;
+    state_      = 0;
+    long_held_  = 0;
+    dropped_    = 0;
+    std::fill(&pressed_us_[0], &pressed_us_[kNumButtons], 0);
+
+    latency_sum_us_ = 0;
+    latency_max_us_ = 0;
+    latency_count_  = 0;
+}
+
+void Buttons::Process(uint8_t pins, uint32_t now_us)
+{
+    const uint8_t delta = pins ^ state_;
+
+    count_low_  = ~(count_low_ & delta);
+    count_high_ = count_low_ ^ (count_high_ & delta);
+
+    // Wrapped from 0 back to 3: the 4th poll in a row to disagree
+    const uint8_t changed = delta & count_low_ & count_high_;
+    state_                = state_ ^ changed;
+
+    for(uint8_t pending = changed; pending != 0; pending &= pending - 1)
+    {
+        const uint8_t button = __builtin_ctz(pending);
+        if((state_ >> button) & 1)
+        {
+            pressed_us_[button] = now_us;
+            long_held_ &= ~(1 << button);
+            Push(ButtonEvent::PRESS, button, now_us);
+        }
+        else
+        {
+            Push(ButtonEvent::RELEASE, button, now_us);
+        }
+    }
+
+    for(uint8_t held = state_ & ~long_held_; held != 0; held &= held - 1)
+    {
+        const uint8_t button = __builtin_ctz(held);
+        if(now_us - pressed_us_[button] >= kLongHoldMs * 1000)
+        {
+            long_held_ |= 1 << button;
+            Push(ButtonEvent::LONG_HOLD, button, now_us);
+        }
+    }
+}
+
+void Buttons::Push(ButtonEvent::Type type, uint8_t button, uint32_t now_us)
+{
+    ButtonEvent event;
+    event.type    = type;
+    event.button  = button;
+    event.down    = state_;
+    event.time_us = now_us;
+
+    if(!events_.Push(event))
+    {
+        dropped_ = dropped_ + 1;
+    }
+}
+
+bool Buttons::Pop(ButtonEvent& event)
+{
+    if(!events_.Pop(event))
+    {
+        return false;
+    }
+
+    const uint32_t latency_us = daisy::System::GetUs() - event.time_us;
+    latency_max_us_           = std::max(latency_max_us_, latency_us);
+    latency_sum_us_ += latency_us;
+    latency_count_++;
+    return true;
+}
+
+uint32_t Buttons::TimeHeldMs(size_t button) const
+{
+    return IsDown(button)
+               ? (daisy::System::GetUs() - pressed_us_[button]) / 1000
+               : 0;
+}
+
+Buttons::Latency Buttons::GetLatency() const
+{
+    Latency latency;
+    latency.avg_us
+        = latency_count_ > 0 ? latency_sum_us_ / latency_count_ : 0;
+    latency.max_us  = latency_max_us_;
+    latency.dropped = dropped_;
+    return latency;
+}
+
+} // namespace fourseas
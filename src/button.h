@@ -1,88 +1,96 @@
 #pragma once
 
 #include "daisy.h"
+#include "src/spsc_queue.h"
 
 namespace fourseas
 {
 
-constexpr uint16_t PRESSED_MASK   = 0xf83f;
-constexpr uint16_t PRESSED_EQUALS = 0x3f;
+struct ButtonEvent
+{
+    enum Type : uint8_t
+    {
+        PRESS,
+        RELEASE,
+        LONG_HOLD, // once per press, Buttons::kLongHoldMs in
+    };
+
+    Type     type;
+    uint8_t  button;
+    uint8_t  down;    // bit n: button n held, just after this event
+    uint32_t time_us; // when the debounced state changed
+};
 
-constexpr uint16_t RELEASED_MASK   = 0xfc1f;
-constexpr uint16_t RELEASED_EQUALS = 0xfc00;
+/**
+    The eight panel buttons, debounced together.
 
+    Each poll goes through a 2-bit vertical counter, one bit-plane per
+    counter bit, so all eight are debounced in a handful of bitwise
+    operations: a button changes state after 4 polls in a row that
+    disagree with it, and any poll that agrees starts its count over.
 
-class Button
+    Changes come out as timestamped events in a single-producer,
+    single-consumer queue: Process() is the producer, from the poll
+    interrupt, and Pop() the consumer, from the main loop. Nothing is
+    missed or seen twice however the main loop is timed.
+*/
+class Buttons
 {
   public:
-    uint16_t* GetState();
-    bool      isPressed();
-    bool      isReleased();
-    bool      isUp();
-    bool      isDown();
-    uint32_t  TimeHeldMs();
-    void      UpdateTimestamp();
+    static constexpr size_t   kNumButtons = 8;
+    static constexpr uint32_t kLongHoldMs = 2000;
 
+    // Time from the debounced change to Pop(), and events lost to a full
+    // queue
+    struct Latency
+    {
+        uint32_t avg_us;
+        uint32_t max_us;
+        uint32_t dropped;
+    };
 
-  private:
-    uint16_t state_        = 0;
-    uint32_t pressed_time_ = 0;
-    bool     was_down_     = false;
-};
+    Buttons() {}
+    ~Buttons() {}
 
+    void Init();
 
-inline uint16_t* Button::GetState()
-{
-    return &state_;
-}
+    /**
+    Takes one poll of the pins, bit n set for button n down, and queues
+    an event for every change. Producer side.
+    */
+    void Process(uint8_t pins, uint32_t now_us);
 
-inline bool Button::isPressed()
-{
-    if((state_ & PRESSED_MASK) == PRESSED_EQUALS)
-    {
-        pressed_time_ = daisy::System::GetNow();
-        state_        = 0xffff;
-        return true;
-    }
-    return false;
-}
+    /** Next event, if any. Consumer side. */
+    bool Pop(ButtonEvent& event);
 
-inline bool Button::isReleased()
-{
-    if((state_ & RELEASED_MASK) == RELEASED_EQUALS)
+    /** Debounced state; these don't touch the queue */
+    inline bool IsDown(size_t button) const
     {
-        state_ = 0;
-        return true;
+        return (state_ >> button) & 1;
     }
-    return false;
-}
+    uint32_t TimeHeldMs(size_t button) const;
 
-inline bool Button::isUp()
-{
-    return state_ == 0;
-}
+    Latency GetLatency() const;
 
-inline bool Button::isDown()
-{
-    return state_ == 0xffff;
-}
-
-inline uint32_t Button::TimeHeldMs()
-{
-    return isDown() ? daisy::System::GetNow() - pressed_time_ : 0;
-}
+  private:
+    static constexpr size_t kQueueSize = 32;
 
-inline void Button::UpdateTimestamp()
-{
-    bool is_down_now = isDown();
+    void Push(ButtonEvent::Type type, uint8_t button, uint32_t now_us);
 
-    if(!was_down_ && is_down_now)
-    {
-        pressed_time_ = daisy::System::GetNow();
-    }
+    // Producer
+    uint8_t           count_low_;
+    uint8_t           count_high_;
+    volatile uint8_t  state_;
+    uint8_t           long_held_; // bit n: LONG_HOLD sent for this press
+    volatile uint32_t pressed_us_[kNumButtons];
+    volatile uint32_t dropped_;
 
-    was_down_ = is_down_now;
-}
+    SpscQueue<ButtonEvent, kQueueSize> events_;
 
+    // Consumer
+    uint32_t latency_sum_us_;
+    uint32_t latency_max_us_;
+    uint32_t latency_count_;
+};
 
 } // namespace fourseas
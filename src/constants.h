@@ -1,12 +1,25 @@
 #pragma once
 
+#include <stddef.h>
+
 namespace fourseas
 {
 constexpr float kMaxFrequency    = 0.25f;
 constexpr float kMinFrequency    = 0.000001f;
 constexpr int   kNumWavesPerBank = 64;
 
-constexpr float kSampleRate     = 48000.0f;
-constexpr int   kAudioBlockSize = 64;
+// Default audio setup. The one actually running comes from AudioConfig
+// (src/audio_config.h); frequencies in cycles per sample, like
+// kMaxFrequency, are relative to kSampleRate.
+constexpr float  kSampleRate     = 48000.0f;
+constexpr size_t kAudioBlockSize = 24;
+
+// Same limit as kMaxFrequency, at any sample rate
+constexpr float kMaxFrequencyHz = kMaxFrequency * kSampleRate;
+
+// Bounds for the block size. The upper one also sizes every per-block
+// scratch buffer in the render path.
+constexpr size_t kMinAudioBlockSize = 8;
+constexpr size_t kMaxAudioBlockSize = 96;
 
 } // namespace fourseas
@@ -0,0 +1,147 @@
+#include "src/cv_stream.h"
+
+#include <algorithm>
+
+using namespace fourseas;
+
+static inline float
+InterpolateHermite(float xm1, float x0, float x1, float x2, float t)
+{
+    const float c     = (x1 - xm1) * 0.5f;
+    const float v     = x0 - x1;
+    const float w     = c + v;
+    const float a     = w + v + (x2 - x0) * 0.5f;
+    const float b_neg = w + a;
+    return (((a * t) - b_neg) * t + c) * t + x0;
+}
+
+void CvStream::Init(AdcMCP3564R*     adc,
+                    AnalogControl24* controls,
+                    uint8_t          channel_mask,
+                    Interpolation    interpolation)
+{
+    adc_           = adc;
+    controls_      = controls;
+    channel_mask_  = channel_mask;
+    interpolation_ = interpolation;
+    write_idx_     = 0;
+    count_         = 0;
+    period_us_     = kDefaultScanPeriodUs;
+
+    for(auto& ramp : ramps_)
+    {
+        std::fill(&ramp[0], &ramp[kMaxAudioBlockSize], 0.0f);
+    }
+}
+
+void CvStream::PushFrame(const AdcMCP3564R::ScanFrame& frame)
+{
+    if(count_ > 0)
+    {
+        // Ignore gaps (e.g. audio was stopped) so they don't skew the period
+        float delta
+            = static_cast<float>(frame.timestamp_us - timestamps_[Slot(0)]);
+        if(delta > 0.0f && delta < period_us_ * 8.0f)
+        {
+            period_us_ += 0.05f * (delta - period_us_);
+        }
+    }
+
+    size_t slot       = write_idx_ & (kHistorySize - 1);
+    timestamps_[slot] = frame.timestamp_us;
+    for(uint8_t ch = 0; ch < kNumChannels; ch++)
+    {
+        if(channel_mask_ & (1 << ch))
+        {
+            history_[slot][ch] = controls_[ch].Normalize(frame.values[ch]);
+        }
+    }
+
+    write_idx_++;
+    count_ = std::min(count_ + 1, kHistorySize);
+}
+
+void CvStream::Process(uint32_t now_us, float sample_rate, size_t size)
+{
+    AdcMCP3564R::ScanFrame frame;
+    while(adc_->GetScanFrames()->Pop(frame))
+    {
+        PushFrame(frame);
+    }
+
+    size = std::min(size, kMaxAudioBlockSize);
+
+    if(count_ < 2)
+    {
+        for(uint8_t ch = 0; ch < kNumChannels; ch++)
+        {
+            if(channel_mask_ & (1 << ch))
+            {
+                float v = count_ ? history_[Slot(0)][ch] : 0.0f;
+                std::fill(&ramps_[ch][0], &ramps_[ch][size], v);
+            }
+        }
+        return;
+    }
+
+    // Frame times relative to the newest frame (all <= 0)
+    const uint32_t newest = timestamps_[Slot(0)];
+    float          rel[kHistorySize];
+    for(size_t age = 0; age < count_; age++)
+    {
+        rel[age] = -static_cast<float>(newest - timestamps_[Slot(age)]);
+    }
+
+    // Locate every sample of the block in the history once; the result is
+    // shared by all enabled channels. The last sample lands LatencyUs()
+    // behind now, and time only moves forward, so the search is incremental.
+    const float dt = 1000000.0f / sample_rate;
+    float t = static_cast<float>(static_cast<int32_t>(now_us - newest))
+              - LatencyUs() - dt * static_cast<float>(size - 1);
+
+    uint8_t seg[kMaxAudioBlockSize];
+    float   frac[kMaxAudioBlockSize];
+    size_t  age = count_ - 1;
+    for(size_t i = 0; i < size; i++, t += dt)
+    {
+        while(age > 1 && t >= rel[age - 1])
+        {
+            age--;
+        }
+        float f = (t - rel[age]) / (rel[age - 1] - rel[age]);
+        seg[i]  = static_cast<uint8_t>(age);
+        frac[i] = std::min(std::max(f, 0.0f), 1.0f);
+    }
+
+    for(uint8_t ch = 0; ch < kNumChannels; ch++)
+    {
+        if(!(channel_mask_ & (1 << ch)))
+        {
+            continue;
+        }
+
+        float* ramp = ramps_[ch];
+        if(interpolation_ == CUBIC)
+        {
+            for(size_t i = 0; i < size; i++)
+            {
+                size_t a  = seg[i];
+                float  p0 = history_[Slot(std::min(a + 1, count_ - 1))][ch];
+                float  p1 = history_[Slot(a)][ch];
+                float  p2 = history_[Slot(a - 1)][ch];
+                float  p3 = history_[Slot(a > 1 ? a - 2 : 0)][ch];
+                ramp[i]   = InterpolateHermite(p0, p1, p2, p3, frac[i]);
+            }
+        }
+        else
+        {
+            for(size_t i = 0; i < size; i++)
+            {
+                size_t a  = seg[i];
+                float  p1 = history_[Slot(a)][ch];
+                float  p2 = history_[Slot(a - 1)][ch];
+                ramp[i]   = p1 + (p2 - p1) * frac[i];
+            }
+        }
+    }
+}
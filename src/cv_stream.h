@@ -0,0 +1,110 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "src/analog_ctrl_24.h"
+#include "src/constants.h"
+#include "src/drivers/MCP3564R.h"
+
+namespace fourseas
+{
+/**
+    Rebuilds audio-rate control signals from the MCP3564R scan stream.
+
+    The ADC scans every channel at ~1.6 kHz (OSR_2048), which is neither a
+    multiple of nor aligned to the audio callback rate. Rather than sampling
+    the newest value once per block, every scan frame is kept with its
+    timestamp and each block is read back from that history at a fixed delay
+    behind real time, using linear or 4-point Hermite interpolation.
+
+    Ramps are built once per block and shared by every consumer.
+*/
+class CvStream
+{
+  public:
+    enum Interpolation
+    {
+        LINEAR,
+        CUBIC,
+    };
+
+    CvStream() {}
+    ~CvStream() {}
+
+    /**
+    \param adc source of the timestamped scan frames
+    \param controls one calibrated control per ADC channel, used to scale
+    raw readings
+    \param channel_mask bit n enables a ramp for ADC channel n
+    \param interpolation LINEAR needs ~1.25 scans of delay, CUBIC ~2.25
+    */
+    void Init(AdcMCP3564R*     adc,
+              AnalogControl24* controls,
+              uint8_t          channel_mask,
+              Interpolation    interpolation = CUBIC);
+
+    /**
+    Drains pending scan frames and builds `size` samples of ramp for every
+    enabled channel. Call once at the top of the audio callback.
+    \param now_us current time from System::GetUs()
+    \param sample_rate audio sample rate in Hz
+    */
+    void Process(uint32_t now_us, float sample_rate, size_t size);
+
+    /**
+    Per-sample normalized values of an enabled channel, valid until the
+    next Process()
+    */
+    inline const float* Ramp(uint8_t channel) const { return ramps_[channel]; }
+
+    inline void SetInterpolation(Interpolation interpolation)
+    {
+        interpolation_ = interpolation;
+    }
+
+    /** Measured time between two scans, in microseconds */
+    inline float ScanPeriodUs() const { return period_us_; }
+
+    /** Delay between a scan being read and the sample it is rendered on */
+    inline float LatencyUs() const
+    {
+        return period_us_
+                   * (interpolation_ == CUBIC ? kCubicLatencyScans
+                                              : kLinearLatencyScans)
+               + static_cast<float>(adc_->DeliveryDelayUs());
+    }
+
+  private:
+    static constexpr size_t  kHistorySize = 8;
+    static constexpr uint8_t kNumChannels = AdcMCP3564R::kNumChannels;
+
+    // Enough scans of delay that the frame(s) after a sample have always
+    // arrived, plus a quarter scan of margin for IRQ jitter.
+    static constexpr float kLinearLatencyScans = 1.25f;
+    static constexpr float kCubicLatencyScans  = 2.25f;
+
+    // ~1.6 kHz at OSR_2048, refined from the frame timestamps
+    static constexpr float kDefaultScanPeriodUs = 625.0f;
+
+    void PushFrame(const AdcMCP3564R::ScanFrame& frame);
+
+    inline size_t Slot(size_t age) const
+    {
+        return (write_idx_ - 1 - age) & (kHistorySize - 1);
+    }
+
+    AdcMCP3564R*     adc_;
+    AnalogControl24* controls_;
+    uint8_t          channel_mask_;
+    Interpolation    interpolation_;
+
+    uint32_t timestamps_[kHistorySize];
+    float    history_[kHistorySize][kNumChannels];
+    size_t   write_idx_;
+    size_t   count_;
+    float    period_us_;
+
+    float ramps_[kNumChannels][kMaxAudioBlockSize];
+};
+
+} // namespace fourseas
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <atomic>
+#include <stdint.h>
+
+namespace fourseas
+{
+/**
+    Latest-value mailbox from one interrupt to lower-priority readers.
+
+    The writer fills the slot that is not published and then publishes it,
+    so the newest item is always whole. A reader copies the published slot
+    and checks afterwards that the writer has not come back round to that
+    slot in the meantime, retrying if it has. Neither side ever blocks.
+
+    Meant for a single core, where the writer can interrupt a reader but
+    not the other way around.
+    \tparam T trivially copyable item
+*/
+template <typename T>
+class DoubleBuffer
+{
+  public:
+    DoubleBuffer() {}
+    ~DoubleBuffer() {}
+
+    /** Writer side. Slot to fill before the next Publish(). */
+    T& Back()
+    {
+        const uint32_t next = published_.load(std::memory_order_relaxed) + 1;
+        writing_.store(next, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        return slots_[next & 1];
+    }
+
+    /** Writer side. Makes the slot from Back() the newest item. */
+    void Publish()
+    {
+        published_.store(writing_.load(std::memory_order_relaxed),
+                         std::memory_order_release);
+    }
+
+    /** Reader side. Copies the newest published item into `item`. */
+    void Read(T& item) const
+    {
+        uint32_t published;
+        do
+        {
+            published = published_.load(std::memory_order_acquire);
+            item      = slots_[published & 1];
+            std::atomic_thread_fence(std::memory_order_acquire);
+            // The writer only reuses this slot two items later
+        } while(writing_.load(std::memory_order_relaxed) - published >= 2);
+    }
+
+  private:
+    T                     slots_[2] = {};
+    std::atomic<uint32_t> published_{0};
+    std::atomic<uint32_t> writing_{0};
+};
+
+} // namespace fourseas
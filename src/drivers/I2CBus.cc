@@ -0,0 +1,272 @@
+#include <algorithm>
+
+#include "daisy.h"
+#include "util/scopedirqblocker.h"
+
+#include "I2CBus.h"
+
+// Interrupts are held off with ScopedIrqBlocker rather than a bare
+// __disable_irq()/__enable_irq() pair: callbacks run inside and may well
+// Submit() again, which must not turn them back on early.
+
+// By I2CHandle::Config::Peripheral, with the DMAMUX1 requests of each (RX,
+// TX). I2C4 is on BDMA, which libDaisy doesn't use for it.
+static I2C_TypeDef* const kInstances[]      = {I2C1, I2C2, I2C3, I2C4};
+static const uint32_t     kDmaRequests[][2] = {
+    {DMA_REQUEST_I2C1_RX, DMA_REQUEST_I2C1_TX},
+    {DMA_REQUEST_I2C2_RX, DMA_REQUEST_I2C2_TX},
+    {DMA_REQUEST_I2C3_RX, DMA_REQUEST_I2C3_TX},
+    {0, 0},
+};
+
+void I2CBus::Init(const daisy::I2CHandle::Config& config)
+{
+    config_ = config;
+    handle_.Init(config_);
+
+    std::fill(&head_[0], &head_[PRIORITY_LAST], 0);
+    std::fill(&count_[0], &count_[PRIORITY_LAST], 0);
+    active_     = false;
+    generation_ = 0;
+    aborting_   = false;
+    stuck_      = false;
+    ResetStats();
+}
+
+daisy::I2CHandle::Result I2CBus::TransmitBlocking(uint16_t address,
+                                                  uint8_t* data,
+                                                  uint16_t size,
+                                                  uint32_t timeout)
+{
+    return handle_.TransmitBlocking(address, data, size, timeout);
+}
+
+bool I2CBus::Submit(Priority priority, const Transaction& transaction)
+{
+    daisy::ScopedIrqBlocker irq_blocker;
+
+    bool queued = false;
+    if(count_[priority] < kQueueSize)
+    {
+        const size_t tail = (head_[priority] + count_[priority]) % kQueueSize;
+        Queued&      slot = queue_[priority][tail];
+        slot.transaction = transaction;
+        slot.queued_us   = daisy::System::GetUs();
+        count_[priority]++;
+        queued = true;
+    }
+    else
+    {
+        stats_.rejected++;
+    }
+
+    if(!active_)
+    {
+        StartNext();
+    }
+    return queued;
+}
+
+void I2CBus::StartNext()
+{
+    // While a given-up transfer is out, libDaisy's DMA is still busy with
+    // it; the queue waits, unless the bus is stuck
+    while(!active_ && (!aborting_ || stuck_))
+    {
+        size_t priority = 0;
+        while(priority < PRIORITY_LAST && count_[priority] == 0)
+        {
+            priority++;
+        }
+        if(priority == PRIORITY_LAST)
+        {
+            return;
+        }
+
+        const Queued& next = queue_[priority][head_[priority]];
+        head_[priority]    = (head_[priority] + 1) % kQueueSize;
+        count_[priority]--;
+
+        current_  = next.transaction;
+        start_us_ = daisy::System::GetUs();
+        active_   = true;
+        generation_++;
+
+        const uint32_t wait_us = start_us_ - next.queued_us;
+        wait_sum_us_[priority] += wait_us;
+        waits_[priority]++;
+        stats_.wait_max_us[priority]
+            = std::max(stats_.wait_max_us[priority], wait_us);
+
+        // A stuck bus fails the transfer straight away, below
+        daisy::I2CHandle::Result res = daisy::I2CHandle::Result::ERR;
+        if(!stuck_)
+        {
+            Ticket& ticket = tickets_[generation_ % 2];
+            ticket         = {this, generation_};
+            if(current_.direction == Direction::TRANSMIT)
+            {
+                res = handle_.TransmitDma(current_.address,
+                                          current_.data,
+                                          current_.size,
+                                          EndCallback,
+                                          &ticket);
+            }
+            else
+            {
+                res = handle_.ReceiveDma(current_.address,
+                                         current_.data,
+                                         current_.size,
+                                         EndCallback,
+                                         &ticket);
+            }
+        }
+
+        // Never started, so no callback is coming: on to the next one
+        if(res != daisy::I2CHandle::Result::OK)
+        {
+            Finish(res);
+        }
+    }
+}
+
+void I2CBus::Finish(daisy::I2CHandle::Result result)
+{
+    const Transaction done = current_;
+
+    busy_us_ += daisy::System::GetUs() - start_us_;
+    if(result == daisy::I2CHandle::Result::OK)
+    {
+        stats_.completed++;
+    }
+    else
+    {
+        stats_.errors++;
+    }
+    active_ = false;
+
+    if(done.callback != nullptr)
+    {
+        done.callback(done.context, result);
+    }
+}
+
+void I2CBus::EndCallback(void* context, daisy::I2CHandle::Result result)
+{
+    const Ticket* ticket = static_cast<const Ticket*>(context);
+    I2CBus*       bus    = ticket->bus;
+
+    daisy::ScopedIrqBlocker irq_blocker;
+    if(bus->active_ && ticket->generation == bus->generation_)
+    {
+        bus->Finish(result);
+    }
+    else
+    {
+        // Late completion of a transfer Service() already gave up on; its
+        // callback has had ERR, and libDaisy's DMA is free again
+        bus->aborting_ = false;
+        bus->stuck_    = false;
+    }
+    bus->StartNext();
+}
+
+/*
+    Stops the running transfer on the bus. libDaisy keeps its HAL handles
+    to itself, so this works on the registers: no more DMA requests, the
+    stream that served them disabled, and a STOP. The transfer then ends
+    through the HAL's own completion interrupt and libDaisy's callback,
+    which is what frees libDaisy's DMA for the next one.
+    HAL_I2C_Master_Abort_IT() would end in HAL_I2C_AbortCpltCallback()
+    instead, which libDaisy doesn't hook, and leave its DMA marked busy.
+*/
+void I2CBus::Abort()
+{
+    const size_t periph = static_cast<size_t>(config_.periph);
+    I2C_TypeDef* i2c    = kInstances[periph];
+
+    CLEAR_BIT(i2c->CR1, I2C_CR1_TXDMAEN | I2C_CR1_RXDMAEN);
+
+    // DMAMUX1 channels 0-7 drive DMA1 streams 0-7, and 8-15 DMA2's
+    for(uint32_t ch = 0; ch < 16 && kDmaRequests[periph][0] != 0; ch++)
+    {
+        const uint32_t request
+            = (DMAMUX1_Channel0 + ch)->CCR & DMAMUX_CxCR_DMAREQ_ID;
+        if(request == kDmaRequests[periph][0]
+           || request == kDmaRequests[periph][1])
+        {
+            DMA_Stream_TypeDef* stream
+                = ch < 8 ? DMA1_Stream0 + ch : DMA2_Stream0 + (ch - 8);
+            CLEAR_BIT(stream->CR, DMA_SxCR_EN);
+        }
+    }
+
+    SET_BIT(i2c->CR2, I2C_CR2_STOP);
+}
+
+void I2CBus::Service()
+{
+    daisy::ScopedIrqBlocker irq_blocker;
+
+    const uint32_t now = daisy::System::GetUs();
+    if(active_ && now - start_us_ > kTimeoutUs)
+    {
+        stats_.timeouts++;
+        Abort();
+        aborting_ = true;
+        abort_us_ = now;
+        Finish(daisy::I2CHandle::Result::ERR);
+        StartNext();
+    }
+    else if(aborting_ && !stuck_ && now - abort_us_ > kTimeoutUs)
+    {
+        // The STOP never went out. A reset frees the lines on this side,
+        // but libDaisy still has the old transfer running and would queue
+        // anything new behind it, so the bus fails transfers instead.
+        handle_.Init(config_);
+        stuck_ = true;
+        StartNext();
+    }
+}
+
+I2CBus::Stats I2CBus::GetStats()
+{
+    Stats    stats;
+    uint32_t busy_us;
+    uint32_t elapsed_us;
+    {
+        daisy::ScopedIrqBlocker irq_blocker;
+
+        stats       = stats_;
+        stats.stuck = stuck_;
+        busy_us     = busy_us_;
+        if(active_)
+        {
+            busy_us += daisy::System::GetUs() - start_us_;
+        }
+        elapsed_us = daisy::System::GetUs() - stats_start_us_;
+    }
+
+    stats.utilisation
+        = elapsed_us > 0
+              ? static_cast<float>(busy_us) / static_cast<float>(elapsed_us)
+              : 0.0f;
+    for(size_t i = 0; i < PRIORITY_LAST; i++)
+    {
+        stats.wait_avg_us[i] = waits_[i] > 0 ? wait_sum_us_[i] / waits_[i] : 0;
+    }
+    return stats;
+}
+
+void I2CBus::ResetStats()
+{
+    daisy::ScopedIrqBlocker irq_blocker;
+
+    stats_          = {};
+    stats_start_us_ = daisy::System::GetUs();
+
+    // A transfer still running only counts from here on
+    busy_us_ = active_ ? start_us_ - stats_start_us_ : 0;
+    std::fill(&wait_sum_us_[0], &wait_sum_us_[PRIORITY_LAST], 0);
+    std::fill(&waits_[0], &waits_[PRIORITY_LAST], 0);
+}
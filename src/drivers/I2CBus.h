@@ -0,0 +1,134 @@
+#pragma once
+
+#include "daisy.h"
+
+/**
+    Owns one I2C peripheral and runs every transfer on it through a queue,
+    so several drivers can share the bus. Transfers go out one at a time
+    with DMA, highest priority first; each one that finishes starts the
+    next from its completion interrupt.
+
+    Submit() may be called from the main loop and from interrupts alike.
+    Buffers must be in DMA-able memory and stay untouched until the
+    transfer's callback has run.
+*/
+class I2CBus
+{
+  public:
+    enum Priority
+    {
+        PRIORITY_HIGH, // e.g. button reads
+        PRIORITY_LOW,  // e.g. LED frames
+
+        PRIORITY_LAST,
+    };
+
+    enum class Direction
+    {
+        TRANSMIT,
+        RECEIVE,
+    };
+
+    struct Transaction
+    {
+        Direction                             direction;
+        uint16_t                              address; // 7-bit
+        uint8_t*                              data;
+        uint16_t                              size;
+        daisy::I2CHandle::CallbackFunctionPtr callback; // may be nullptr
+        void*                                 context;
+    };
+
+    struct Stats
+    {
+        uint32_t completed;
+        uint32_t errors;      // transfers that ended in an error
+        uint32_t timeouts;    // transfers given up on, see Service()
+        bool     stuck;       // the bus never let go of one, see Service()
+        uint32_t rejected;    // Submit() calls that found the queue full
+        float    utilisation; // share of the time a transfer was running
+
+        // From Submit() to the transfer going out on the bus
+        uint32_t wait_avg_us[PRIORITY_LAST];
+        uint32_t wait_max_us[PRIORITY_LAST];
+    };
+
+    I2CBus() {}
+    ~I2CBus() {}
+
+    void Init(const daisy::I2CHandle::Config& config);
+
+    /** For setting devices up, before anything has been submitted */
+    daisy::I2CHandle::Result TransmitBlocking(uint16_t address,
+                                              uint8_t* data,
+                                              uint16_t size,
+                                              uint32_t timeout);
+
+    /** Queues a transfer. Returns false if that priority's queue is full */
+    bool Submit(Priority priority, const Transaction& transaction);
+
+    /**
+    Gives up on a transfer that has run for longer than kTimeoutUs: it is
+    stopped on the bus and its callback gets ERR. The queue moves on once
+    libDaisy has seen the stopped transfer end, which frees its DMA.
+
+    If that doesn't happen within another kTimeoutUs (e.g. a device holds
+    SCL low), the peripheral is set up again and the bus is stuck: every
+    transfer fails with ERR until the old one does come back. Call
+    regularly, e.g. from a timer interrupt.
+    */
+    void Service();
+
+    Stats GetStats();
+    void  ResetStats();
+
+  private:
+    static constexpr size_t   kQueueSize = 4;
+    static constexpr uint32_t kTimeoutUs = 5000;
+
+    struct Queued
+    {
+        Transaction transaction;
+        uint32_t    queued_us;
+    };
+
+    // Callback context of one started transfer, so EndCallback() can tell
+    // a late completion from the current one
+    struct Ticket
+    {
+        I2CBus*  bus;
+        uint32_t generation;
+    };
+
+    static void EndCallback(void* context, daisy::I2CHandle::Result result);
+
+    // These expect interrupts to be off
+    void StartNext();
+    void Finish(daisy::I2CHandle::Result result);
+    void Abort();
+
+    daisy::I2CHandle         handle_;
+    daisy::I2CHandle::Config config_;
+
+    Queued  queue_[PRIORITY_LAST][kQueueSize];
+    uint8_t head_[PRIORITY_LAST];
+    uint8_t count_[PRIORITY_LAST];
+
+    volatile bool active_;
+    Transaction   current_;
+    uint32_t      start_us_;
+
+    // Nothing new starts while a given-up transfer is still out, so one
+    // ticket for it and one for the current transfer are enough
+    Ticket        tickets_[2];
+    uint32_t      generation_;
+    volatile bool aborting_; // a given-up transfer hasn't come back yet
+    uint32_t      abort_us_;
+    volatile bool stuck_;
+
+    uint32_t stats_start_us_;
+    uint32_t busy_us_;
+    uint32_t wait_sum_us_[PRIORITY_LAST];
+    uint32_t waits_[PRIORITY_LAST];
+    Stats    stats_;
+};
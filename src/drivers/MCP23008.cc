@@ -3,23 +3,19 @@
 #include "daisy_seed.h"
 #include "MCP23008.h"
 
-constexpr daisy::Pin PIN_I2C1_SCL = daisy::seed::D11; // 12
-constexpr daisy::Pin PIN_I2C1_SDA = daisy::seed::D12; // 13
+// IOCON: sequential operation disabled, so the address pointer stays put
+constexpr uint8_t kIOConSeqOpDisabled = 1 << 5;
 
-void MCP23008::Init(uint8_t addr)
+static uint8_t DMA_BUFFER_MEM_SECTION mcp23008_i2c_rx_buffer[1];
+
+void MCP23008::Init(I2CBus* bus, uint8_t addr)
 {
+    bus_      = bus;
     i2c_addr_ = addr;
-
-    daisy::I2CHandle::Config i2c_config;
-
-    i2c_config.periph = daisy::I2CHandle::Config::Peripheral::I2C_1;
-
-    i2c_config.speed          = daisy::I2CHandle::Config::Speed::I2C_1MHZ;
-    i2c_config.mode           = daisy::I2CHandle::Config::Mode::I2C_MASTER;
-    i2c_config.pin_config.scl = PIN_I2C1_SCL;
-    i2c_config.pin_config.sda = PIN_I2C1_SDA;
-
-    i2c_handle_.Init(i2c_config);
+    state_    = 0;
+    reading_  = false;
+    errors_   = 0;
+    skipped_  = 0;
 
     // Init device
     static constexpr uint16_t size    = 2;
@@ -29,23 +25,62 @@ void MCP23008::Init(uint8_t addr)
     uint8_t data = 0xFF;
 
     uint8_t payload[2] = {reg, data};
-    i2c_handle_.TransmitBlocking(i2c_addr_, payload, size, timeout);
+    bus_->TransmitBlocking(i2c_addr_, payload, size, timeout);
 
     reg        = MCP23008::IPOL;
     payload[0] = reg;
     payload[1] = 0xFF;
-    i2c_handle_.TransmitBlocking(i2c_addr_, payload, size, timeout);
+    bus_->TransmitBlocking(i2c_addr_, payload, size, timeout);
+
+    // Leave the address pointer on GPIO, so a read is just a read and
+    // needs no register write in front of it
+    payload[0] = MCP23008::IOCON;
+    payload[1] = kIOConSeqOpDisabled;
+    bus_->TransmitBlocking(i2c_addr_, payload, size, timeout);
+
+    reg = MCP23008::GPIO;
+    bus_->TransmitBlocking(i2c_addr_, &reg, 1, timeout);
 }
 
-uint8_t MCP23008::Fetch()
+void MCP23008::StartFetch()
 {
-    static constexpr uint32_t timeout = 10000;
+    // Not set up (e.g. TESTING_FIRMWARE)
+    if(bus_ == nullptr)
+    {
+        return;
+    }
+    if(reading_)
+    {
+        skipped_++;
+        return;
+    }
 
-    // reset MODE1 register
-    static constexpr uint8_t reg     = MCP23008::GPIO; // MODE1 register
-    uint8_t                  data[1] = {0x00};
+    I2CBus::Transaction read;
+    read.direction = I2CBus::Direction::RECEIVE;
+    read.address   = i2c_addr_;
+    read.data      = mcp23008_i2c_rx_buffer;
+    read.size      = 1;
+    read.callback  = ReadCallback;
+    read.context   = this;
 
-    i2c_handle_.ReadDataAtAddress(i2c_addr_ << 1, reg, 1, data, 1, timeout);
+    reading_ = true;
+    if(!bus_->Submit(I2CBus::PRIORITY_HIGH, read))
+    {
+        reading_ = false;
+        skipped_++;
+    }
+}
 
-    return data[0];
-}
\ No newline at end of file
+void MCP23008::ReadCallback(void* context, daisy::I2CHandle::Result result)
+{
+    MCP23008* instance = static_cast<MCP23008*>(context);
+    if(result == daisy::I2CHandle::Result::OK)
+    {
+        instance->state_ = mcp23008_i2c_rx_buffer[0];
+    }
+    else
+    {
+        instance->errors_ = instance->errors_ + 1;
+    }
+    instance->reading_ = false;
+}
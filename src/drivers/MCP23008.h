@@ -2,6 +2,8 @@
 
 #include "daisy.h"
 
+#include "I2CBus.h"
+
 class MCP23008
 {
   public:
@@ -23,10 +25,31 @@ class MCP23008
     MCP23008() {}
     ~MCP23008() {}
 
-    void    Init(uint8_t addr);
-    uint8_t Fetch();
+    /** Sets the expander up, blocking; before `bus` has anything queued */
+    void Init(I2CBus* bus, uint8_t addr);
+
+    /**
+    Queues a read of GPIO on the bus, ahead of anything of lower priority,
+    and returns straight away; safe to call from an interrupt. The result
+    shows up in GetState() once the transfer is done. A call while the
+    last read is still queued or going is skipped.
+    */
+    void StartFetch();
+
+    /** Pins as of the last read that completed */
+    inline uint8_t GetState() const { return state_; }
+
+    /** Reads that failed on the bus, and calls skipped for a busy read */
+    inline uint32_t GetErrors() const { return errors_; }
+    inline uint32_t GetSkipped() const { return skipped_; }
 
   private:
-    uint8_t          i2c_addr_;
-    daisy::I2CHandle i2c_handle_;
-};
\ No newline at end of file
+    static void ReadCallback(void* context, daisy::I2CHandle::Result result);
+
+    uint8_t           i2c_addr_;
+    I2CBus*           bus_ = nullptr;
+    volatile uint8_t  state_;
+    volatile bool     reading_;
+    volatile uint32_t errors_;
+    uint32_t          skipped_;
+};
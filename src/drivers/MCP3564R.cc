@@ -1,9 +1,13 @@
 #include <algorithm>
+#include <math.h>
+#include <stddef.h>
+#include <string.h>
 
 #include "daisy.h"
 
 #include "daisy_seed.h"
 #include "MCP3564R.h"
+#include "MCP3564R_words.h"
 
 
 // Device constants: registers, defaults, etc.
@@ -21,6 +25,17 @@ const uint8_t kRegConfig3Default = 0b0;
 const uint8_t kRegIRQDefault = 0b01110011;
 const uint8_t kRegMUXDefault = 0b1;
 
+// What the registers hold after a reset
+const AdcMCP3564R::Registers kRegistersDefault = {
+    {kRegConfig0Default,
+     kRegConfig1Default,
+     kRegConfig2Default,
+     kRegConfig3Default},
+    kRegIRQDefault,
+    kRegMUXDefault,
+    {0, 0, 0},
+};
+
 
 // SPI pins
 constexpr daisy::Pin ADC_PIN_SPI1_MOSI = daisy::seed::D10; // Seed2 B4
@@ -28,16 +43,62 @@ constexpr daisy::Pin ADC_PIN_SPI1_MISO = daisy::seed::D9;  // Seed2 B1
 constexpr daisy::Pin ADC_PIN_SPI1_SCK  = daisy::seed::D8;  // Seed2 B2
 constexpr daisy::Pin ADC_PIN_SPI1_CS   = daisy::seed::D7;  // Seed2 B6
 
-constexpr uint8_t NUM_ADC_CHANNELS = 8;
+constexpr uint8_t NUM_ADC_CHANNELS = kAdcNumChannels;
+
+// Decoded in the ADC interrupts and only touched there
+static int32_t  channel_values[NUM_ADC_CHANNELS];
+static uint8_t  channel_overrange = 0;
+static uint32_t scan_sequence     = 0;
+
+// What the SCAN register has on. Written only while no scan is being
+// read (see Config::Commit()).
+static AdcScanOrder      scan_order;
+static volatile uint32_t sync_errors = 0;
+
+// Handshake between Config::Commit() and the data-ready path, which
+// share SPI1: no new scan read starts while configuring is set
+static volatile bool configuring     = false;
+static volatile bool transfer_active = false;
+
+static fourseas::DoubleBuffer<AdcMCP3564R::ScanFrame> latest_scan;
 
-uint32_t channel_values[8];
+static AdcMCP3564R::ScanFrameQueue scan_frames;
+static volatile uint32_t           dropped_frames = 0;
+
+static AdcMCP3564R::ScanTiming scan_timing    = {};
+static uint32_t                timed_scans    = 0;
+static uint32_t                last_scan_time = 0;
+static volatile uint8_t        fresh_channels = 0;
+
+// Scans before jitter is counted, while the period average settles
+constexpr uint32_t kTimingWarmupScans = 64;
 
 constexpr size_t BUFFER_SIZE = 33;
+constexpr size_t kBurstWords = (BUFFER_SIZE - 1) / 4; // after the command
 
 /** outside of class static buffer(s) for DMA access */
 static uint8_t DMA_BUFFER_MEM_SECTION spi_tx_buffer[BUFFER_SIZE];
 static uint8_t DMA_BUFFER_MEM_SECTION spi_rx_buffer[BUFFER_SIZE];
 
+// Free-running stream, see StartStreaming(). One byte every 2 us, and an
+// event every 256 bytes (64 words, 512 us).
+constexpr uint32_t kStreamBytePeriodUs = 2;
+constexpr size_t   kStreamHalfBytes    = 256;
+constexpr size_t   kStreamBytes        = 2 * kStreamHalfBytes;
+
+static uint8_t DMA_BUFFER_MEM_SECTION stream_tx_buffer[kStreamBytes];
+static uint8_t DMA_BUFFER_MEM_SECTION stream_rx_buffer[kStreamBytes];
+
+static TIM_HandleTypeDef stream_timer;
+static DMA_HandleTypeDef stream_tx_dma;
+static DMA_HandleTypeDef stream_rx_dma;
+
+static AdcWordStream stream_words;
+static uint32_t      stream_received;  // bytes in since StartStreaming()
+static uint32_t      stream_start_us;  // when byte 0 was clocked in
+static uint32_t      stream_scan_time; // newest word of the scan being built
+static uint8_t       stream_fresh;     // channels read in the scan being built
+
 inline void constructTxData(uint8_t*                    buffer,
                             AdcMCP3564R::ConfigRegister confReg,
                             AdcMCP3564R::CommandType    cmd,
@@ -47,6 +108,12 @@ inline void constructTxData(uint8_t*                    buffer,
     buffer[1] = data;
 }
 
+// Takes the scanned channels from SCAN_CH[7:0]
+static void SetScanChannels(const AdcMCP3564R::Registers& regs)
+{
+    scan_order.Set(regs.scan[2]);
+}
+
 AdcMCP3564R::Result AdcMCP3564R::Init()
 {
     daisy::SpiHandle::Config spi_config = daisy::SpiHandle::Config();
@@ -59,7 +126,10 @@ AdcMCP3564R::Result AdcMCP3564R::Init()
     spi_tx_buffer[0] = kDeviceAddress | (kRegAdcData << 2)
                        | AdcMCP3564R::CommandType::STATIC_READ;
 
-    val_ = channel_values;
+    shadow_        = kRegistersDefault;
+    last_sequence_ = 0;
+    SetScanChannels(shadow_);
+    std::fill(&stats_[0], &stats_[kNumChannels], ChannelStats{0, 0});
 
     spi_config.periph    = daisy::SpiHandle::Config::Peripheral::SPI_1;
     spi_config.mode      = daisy::SpiHandle::Config::Mode::MASTER;
@@ -95,6 +165,8 @@ AdcMCP3564R::Result AdcMCP3564R::ResetDefaults()
     {
         return AdcMCP3564R::Result::ERR;
     }
+    shadow_ = kRegistersDefault;
+    SetScanChannels(shadow_);
     return AdcMCP3564R::Result::OK;
 }
 
@@ -116,247 +188,295 @@ uint8_t AdcMCP3564R::GetConfig(AdcMCP3564R::ConfigRegister reg)
     return rx[1];
 }
 
-void AdcMCP3564R::UseInternalVRef(bool ref)
-{
-    AdcMCP3564R::ConfigRegister confReg = AdcMCP3564R::ConfigRegister::CONFIG0;
-
+// Batched configuration: see AdcMCP3564R::Config
 
-    uint8_t conf_val = GetConfig(confReg);
+static_assert(sizeof(AdcMCP3564R::Registers) == 9,
+              "Registers must match CONFIG0 to SCAN byte for byte");
 
-    uint8_t data;
-    if(ref)
-    {
-        data = conf_val | (1 << 7);
-    }
-    else
-    {
-        data = conf_val & ~(1 << 7);
-    }
-
-    uint8_t tx[2];
-    constructTxData(tx, confReg, AdcMCP3564R::CommandType::INCR_WRITE, data);
+AdcMCP3564R::Config AdcMCP3564R::Configure()
+{
+    return Config(this);
+}
 
-    uint8_t rx[2];
+AdcMCP3564R::Config&
+AdcMCP3564R::Config::SetConfig(AdcMCP3564R::ConfigRegister reg,
+                               uint8_t                     mask,
+                               uint8_t                     bits)
+{
+    uint8_t& value = staged_.config[reg - CONFIG0];
+    value          = (value & ~mask) | (bits & mask);
+    return *this;
+}
 
-    uint16_t size    = 2;
-    uint32_t timeout = 100;
+AdcMCP3564R::Config& AdcMCP3564R::Config::UseInternalVRef(bool ref)
+{
+    return SetConfig(CONFIG0, 1 << 7, ref ? 1 << 7 : 0);
+}
 
-    spi_handle_.BlockingTransmitAndReceive(tx, rx, size, timeout);
+AdcMCP3564R::Config& AdcMCP3564R::Config::SetClock(AdcMCP3564R::ClkSel clk)
+{
+    return SetConfig(CONFIG0, 0b00110000, clk << 4);
 }
 
-void AdcMCP3564R::SetClock(AdcMCP3564R::ClkSel clk)
+AdcMCP3564R::Config&
+AdcMCP3564R::Config::SetAMCLKPrescaler(AdcMCP3564R::AMCLKSel clkps)
 {
-    AdcMCP3564R::ConfigRegister confReg = AdcMCP3564R::ConfigRegister::CONFIG0;
+    return SetConfig(CONFIG1, 0b11000000, clkps << 6);
+}
 
-    uint8_t conf_val = GetConfig(confReg);
-    uint8_t bits     = clk << 4;
-    uint8_t mask     = 0b00110000;
+AdcMCP3564R::Config&
+AdcMCP3564R::Config::SetOversamplingRatio(AdcMCP3564R::OSRSel sr)
+{
+    return SetConfig(CONFIG1, 0b00111100, sr << 2);
+}
 
-    uint8_t data = (conf_val & ~mask) | (bits & mask);
+AdcMCP3564R::Config&
+AdcMCP3564R::Config::SetBoost(AdcMCP3564R::BoostSel boost)
+{
+    return SetConfig(CONFIG2, 0b11000000, boost << 6);
+}
 
-    uint16_t size = 2;
+AdcMCP3564R::Config&
+AdcMCP3564R::Config::SetConversionMode(AdcMCP3564R::ConversionMode mode)
+{
+    return SetConfig(CONFIG3, 0b11 << 6, mode << 6);
+}
 
-    uint8_t tx[size];
-    constructTxData(tx, confReg, AdcMCP3564R::CommandType::INCR_WRITE, data);
+AdcMCP3564R::Config&
+AdcMCP3564R::Config::SetADCMode(AdcMCP3564R::ADCMode mode)
+{
+    return SetConfig(CONFIG0, 0b11, mode);
+}
 
-    uint8_t rx[size];
+AdcMCP3564R::Config&
+AdcMCP3564R::Config::SetMuxReg(AdcMCP3564R::MuxMode msb,
+                               AdcMCP3564R::MuxMode lsb)
+{
+    staged_.mux = (msb << 4) | lsb;
+    return *this;
+}
 
-    uint32_t timeout = 100;
+AdcMCP3564R::Config& AdcMCP3564R::Config::SetIRQPin()
+{
+    // Bits [7:4] are read only
+    staged_.irq = 0b00000011;
+    return *this;
+}
 
-    spi_handle_.BlockingTransmitAndReceive(tx, rx, size, timeout);
+AdcMCP3564R::Config&
+AdcMCP3564R::Config::SetDataFormat(AdcMCP3564R::DataFormats df)
+{
+    return SetConfig(CONFIG3, 0b11 << 4, df << 4);
 }
 
-void AdcMCP3564R::SetAMCLKPrescaler(AdcMCP3564R::AMCLKSel clkps)
+AdcMCP3564R::Config&
+AdcMCP3564R::Config::SetScanRegister(AdcMCP3564R::ScanDelayTimes scan_delay,
+                                     uint16_t                    channels)
 {
-    AdcMCP3564R::ConfigRegister confReg = AdcMCP3564R::ConfigRegister::CONFIG1;
+    // DLY[2:0] is bits [23:21]
+    staged_.scan[0] = static_cast<uint8_t>(scan_delay << 5);
+    staged_.scan[1] = static_cast<uint8_t>(channels >> 8);
+    staged_.scan[2] = static_cast<uint8_t>(channels & 0xff);
+    return *this;
+}
 
-    uint8_t conf_val = GetConfig(confReg);
-    uint8_t bits     = clkps << 6;
-    uint8_t mask     = 0b11000000;
+AdcMCP3564R::Result AdcMCP3564R::Config::Commit()
+{
+    // The register access needs SPI1 to itself
+    const bool streaming = adc_->streaming_;
+    if(streaming)
+    {
+        adc_->StopStreaming();
+    }
+    else
+    {
+        configuring = true;
+        const uint32_t start = daisy::System::GetNow();
+        while(transfer_active && daisy::System::GetNow() - start < 2) {}
+    }
 
-    uint8_t data = (conf_val & ~mask) | (bits & mask);
+    // Only from the first changed register to the last, so a change of
+    // scan set alone is a 3-byte write. SCAN is the one register wider
+    // than a byte.
+    constexpr size_t kScan = offsetof(AdcMCP3564R::Registers, scan);
+    constexpr size_t kEnd  = sizeof(AdcMCP3564R::Registers) - 1;
+
+    const uint8_t* staged = reinterpret_cast<const uint8_t*>(&staged_);
+    const uint8_t* shadow = reinterpret_cast<const uint8_t*>(&adc_->shadow_);
+    size_t         first  = kEnd;
+    size_t         last   = 0;
+    for(size_t i = 0; i <= kEnd; i++)
+    {
+        if(staged[i] != shadow[i])
+        {
+            first = std::min(first, i);
+            last  = i;
+        }
+    }
+    if(first > last)
+    {
+        first = 0; // nothing changed: write them all anyway
+        last  = kEnd;
+    }
+    first = std::min(first, kScan);
+    last  = last >= kScan ? kEnd : last;
 
-    uint8_t tx[2];
-    constructTxData(tx, confReg, AdcMCP3564R::CommandType::INCR_WRITE, data);
+    // Outside the span the ADC is taken to match
+    AdcMCP3564R::Registers actual = staged_;
 
-    uint8_t rx[2];
+    AdcMCP3564R::Result res = adc_->WriteRegisters(staged_, first, last);
+    if(res == AdcMCP3564R::Result::OK)
+    {
+        res = adc_->ReadRegisters(actual, first, last);
+    }
 
-    uint16_t size    = 2;
-    uint32_t timeout = 100;
+    if(res == AdcMCP3564R::Result::OK)
+    {
+        // IRQ status bits are live, and ADC_MODE moves on by itself
+        // outside of continuous conversion
+        AdcMCP3564R::Registers expected = staged_;
+        expected.irq &= 0x0f;
+        actual.irq &= 0x0f;
+        if((expected.config[CONFIG3 - CONFIG0] >> 6) != CONTINUOUS)
+        {
+            expected.config[0] &= ~0b11;
+            actual.config[0] &= ~0b11;
+        }
+        adc_->shadow_ = staged_;
+        if(memcmp(&expected, &actual, sizeof(actual)) != 0)
+        {
+            adc_->ReadRegisters(adc_->shadow_);
+            res = AdcMCP3564R::Result::ERR;
+        }
+        SetScanChannels(adc_->shadow_);
+    }
 
-    spi_handle_.BlockingTransmitAndReceive(tx, rx, size, timeout);
+    configuring = false;
+    if(streaming)
+    {
+        adc_->StartStreaming();
+    }
+    return res;
 }
 
-void AdcMCP3564R::SetBoost(AdcMCP3564R::BoostSel boost)
+// Register addresses count up from CONFIG0 a byte at a time until SCAN,
+// the last of Registers
+static uint8_t RegisterCommand(size_t first, AdcMCP3564R::CommandType cmd)
 {
-    AdcMCP3564R::ConfigRegister confReg = AdcMCP3564R::ConfigRegister::CONFIG2;
-
-    uint8_t conf_val = GetConfig(confReg);
-    uint8_t bits     = boost << 6;
-    uint8_t mask     = 0b11000000;
+    const size_t address = AdcMCP3564R::CONFIG0 + first;
+    return static_cast<uint8_t>(kDeviceAddress | (address << 2) | cmd);
+}
 
-    uint8_t data = (conf_val & ~mask) | (bits & mask);
+AdcMCP3564R::Result
+AdcMCP3564R::WriteRegisters(const Registers& regs, size_t first, size_t last)
+{
+    const uint16_t count = last - first + 1;
+    const uint16_t size  = 1 + count;
 
-    uint8_t tx[2];
-    constructTxData(tx, confReg, AdcMCP3564R::CommandType::INCR_WRITE, data);
+    uint8_t tx[1 + sizeof(Registers)] = {};
+    tx[0] = RegisterCommand(first, AdcMCP3564R::CommandType::INCR_WRITE);
+    memcpy(&tx[1], reinterpret_cast<const uint8_t*>(&regs) + first, count);
 
-    uint8_t rx[2];
+    uint8_t rx[1 + sizeof(Registers)];
 
-    uint16_t size    = 2;
     uint32_t timeout = 100;
 
-    spi_handle_.BlockingTransmitAndReceive(tx, rx, size, timeout);
+    if(spi_handle_.BlockingTransmitAndReceive(tx, rx, size, timeout)
+       != daisy::SpiHandle::Result::OK)
+    {
+        return AdcMCP3564R::Result::ERR;
+    }
+    return AdcMCP3564R::Result::OK;
 }
 
-
-void AdcMCP3564R::SetOversamplingRatio(AdcMCP3564R::OSRSel sr)
+AdcMCP3564R::Result AdcMCP3564R::ReadRegisters(Registers& regs)
 {
-    AdcMCP3564R::ConfigRegister confReg = AdcMCP3564R::ConfigRegister::CONFIG1;
-
-    uint8_t conf_val = GetConfig(confReg);
-    uint8_t bits     = sr << 2;
-    uint8_t mask     = 0b00111100;
-
-    uint8_t data = (conf_val & ~mask) | (bits & mask);
+    return ReadRegisters(regs, 0, sizeof(Registers) - 1);
+}
 
+AdcMCP3564R::Result
+AdcMCP3564R::ReadRegisters(Registers& regs, size_t first, size_t last)
+{
+    const uint16_t count = last - first + 1;
+    const uint16_t size  = 1 + count;
 
-    uint8_t tx[2];
-    constructTxData(tx, confReg, AdcMCP3564R::CommandType::INCR_WRITE, data);
+    uint8_t tx[1 + sizeof(Registers)] = {};
+    tx[0] = RegisterCommand(first, AdcMCP3564R::CommandType::INCR_READ);
 
-    uint8_t rx[2];
+    uint8_t rx[1 + sizeof(Registers)];
 
-    uint16_t size    = 2;
     uint32_t timeout = 100;
 
-    spi_handle_.BlockingTransmitAndReceive(tx, rx, size, timeout);
+    if(spi_handle_.BlockingTransmitAndReceive(tx, rx, size, timeout)
+       != daisy::SpiHandle::Result::OK)
+    {
+        return AdcMCP3564R::Result::ERR;
+    }
+    memcpy(reinterpret_cast<uint8_t*>(&regs) + first, &rx[1], count);
+    return AdcMCP3564R::Result::OK;
 }
 
-void AdcMCP3564R::SetConversionMode(AdcMCP3564R::ConversionMode mode)
+void AdcMCP3564R::UseInternalVRef(bool ref)
 {
-    AdcMCP3564R::ConfigRegister confReg = AdcMCP3564R::ConfigRegister::CONFIG3;
-
-    uint8_t conf_val = GetConfig(confReg);
-    uint8_t bits     = mode << 6;
-    uint8_t mask     = 0b11 << 6;
+    Configure().UseInternalVRef(ref).Commit();
+}
 
-    uint8_t data = (conf_val & ~mask) | (bits & mask);
+void AdcMCP3564R::SetClock(AdcMCP3564R::ClkSel clk)
+{
+    Configure().SetClock(clk).Commit();
+}
 
-    uint8_t tx[2];
-    constructTxData(tx, confReg, AdcMCP3564R::CommandType::INCR_WRITE, data);
+void AdcMCP3564R::SetAMCLKPrescaler(AdcMCP3564R::AMCLKSel clkps)
+{
+    Configure().SetAMCLKPrescaler(clkps).Commit();
+}
 
-    uint8_t rx[2];
+void AdcMCP3564R::SetBoost(AdcMCP3564R::BoostSel boost)
+{
+    Configure().SetBoost(boost).Commit();
+}
 
-    uint16_t size    = 2;
-    uint32_t timeout = 100;
+void AdcMCP3564R::SetOversamplingRatio(AdcMCP3564R::OSRSel sr)
+{
+    Configure().SetOversamplingRatio(sr).Commit();
+}
 
-    spi_handle_.BlockingTransmitAndReceive(tx, rx, size, timeout);
+void AdcMCP3564R::SetConversionMode(AdcMCP3564R::ConversionMode mode)
+{
+    Configure().SetConversionMode(mode).Commit();
 }
 
 void AdcMCP3564R::SetADCMode(AdcMCP3564R::ADCMode mode)
 {
-    AdcMCP3564R::ConfigRegister confReg = AdcMCP3564R::ConfigRegister::CONFIG0;
-
-    uint8_t conf_val = GetConfig(confReg);
-    uint8_t mask     = 0b11;
-
-    uint8_t data = (conf_val & ~mask) | (mode & mask);
-
-    uint8_t tx[2];
-    constructTxData(tx, confReg, AdcMCP3564R::CommandType::INCR_WRITE, data);
-
-    uint8_t rx[2];
-
-    uint16_t size    = 2;
-    uint32_t timeout = 100;
-
-    spi_handle_.BlockingTransmitAndReceive(tx, rx, size, timeout);
+    Configure().SetADCMode(mode).Commit();
 }
 
 void AdcMCP3564R::SetMuxReg(AdcMCP3564R::MuxMode msb, AdcMCP3564R::MuxMode lsb)
 {
-    uint8_t data = (msb << 4) | lsb;
-
-    uint8_t tx[2] = {kDeviceAddress | (kRegMultiplexer << 2)
-                         | AdcMCP3564R::CommandType::INCR_WRITE,
-                     data};
-
-    uint8_t rx[2];
-
-    uint16_t size    = 2;
-    uint32_t timeout = 100;
-
-    spi_handle_.BlockingTransmitAndReceive(tx, rx, size, timeout);
+    Configure().SetMuxReg(msb, lsb).Commit();
 }
 
 void AdcMCP3564R::SetIRQPin()
 {
-    // Bits [8:4] are read only
-    uint8_t data = 0b00000011;
-
-    uint8_t tx[2] = {kDeviceAddress | (kRegIRQ << 2)
-                         | AdcMCP3564R::CommandType::INCR_WRITE,
-                     data};
-
-    uint8_t rx[2];
-
-    uint16_t size    = 2;
-    uint32_t timeout = 100;
-
-    spi_handle_.BlockingTransmitAndReceive(tx, rx, size, timeout);
+    Configure().SetIRQPin().Commit();
 }
 
 void AdcMCP3564R::SetDataFormat(AdcMCP3564R::DataFormats df)
 {
-    AdcMCP3564R::ConfigRegister confReg = AdcMCP3564R::ConfigRegister::CONFIG3;
-
-    uint8_t conf_val = GetConfig(confReg);
-    uint8_t bits     = df << 4;
-    uint8_t mask     = 0b11 << 4;
-
-    uint8_t data = (conf_val & ~mask) | (bits & mask);
-
-    constexpr uint16_t size = 2;
-
-    uint8_t tx[size];
-    constructTxData(tx, confReg, AdcMCP3564R::CommandType::INCR_WRITE, data);
-
-    uint8_t rx[size];
-
-    uint32_t timeout = 100;
-
-    spi_handle_.BlockingTransmitAndReceive(tx, rx, size, timeout);
+    Configure().SetDataFormat(df).Commit();
 }
 
 void AdcMCP3564R::SetScanRegister(AdcMCP3564R::ScanDelayTimes scan_delay,
                                   uint16_t                    channels)
 {
-    constexpr uint16_t size = 4;
-    uint8_t            tx[size]
-        = {static_cast<uint8_t>(kDeviceAddress | (kRegScan << 2)
-                                | AdcMCP3564R::CommandType::INCR_WRITE),
-           static_cast<uint8_t>(scan_delay << 6),
-           static_cast<uint8_t>(channels >> 8),
-           static_cast<uint8_t>(channels & 0xff)};
-
-    uint8_t rx[size];
-
-    uint32_t timeout = 100;
-
-    spi_handle_.BlockingTransmitAndReceive(tx, rx, size, timeout);
+    Configure().SetScanRegister(scan_delay, channels).Commit();
 }
 
 uint32_t AdcMCP3564R::GetScanRegister()
 {
-    constexpr uint16_t size     = 4;
-    uint8_t            tx[size] = {kDeviceAddress | (kRegScan << 2)
-                                   | AdcMCP3564R::CommandType::STATIC_READ};
-
-    uint8_t rx[size];
-
-    uint32_t timeout = 100;
-
-    spi_handle_.BlockingTransmitAndReceive(tx, rx, size, timeout);
-    return rx[0] << 16 | rx[1] << 8 | rx[2];
+    Registers regs;
+    ReadRegisters(regs);
+    return regs.scan[0] << 16 | regs.scan[1] << 8 | regs.scan[2];
 }
 
 bool AdcMCP3564R::GetDataReady()
@@ -378,38 +498,126 @@ bool AdcMCP3564R::GetDataReady()
     return (rx[1] & mask) == 0;
 }
 
-uint32_t AdcMCP3564R::Get(uint8_t idx)
+bool AdcMCP3564R::ReadScan(AdcMCP3564R::ScanFrame& frame)
 {
-    return val_[idx];
+    latest_scan.Read(frame);
+
+    const uint32_t scans = frame.sequence - last_sequence_;
+    last_sequence_       = frame.sequence;
+
+    for(uint8_t ch = 0; ch < kNumChannels; ch++)
+    {
+        if(scans == 0 || !(frame.fresh & (1 << ch)))
+        {
+            stats_[ch].stale++;
+        }
+        else
+        {
+            stats_[ch].dropped += scans - 1;
+        }
+    }
+    return scans != 0;
 }
 
-uint32_t* AdcMCP3564R::GetPtr(uint8_t idx)
+const AdcMCP3564R::ChannelStats&
+AdcMCP3564R::GetChannelStats(uint8_t idx) const
 {
-    return &val_[idx];
+    return stats_[idx];
 }
 
-void endCallback_(void* state, daisy::SpiHandle::Result res)
+AdcMCP3564R::ScanFrameQueue* AdcMCP3564R::GetScanFrames()
+{
+    return &scan_frames;
+}
+
+uint32_t AdcMCP3564R::GetDroppedFrames()
 {
-    uint8_t ch_idx, sign_bit;
+    return dropped_frames;
+}
 
-    // TODO: tune this to guarantee the correct channel index
-    // Also, check that the conversion to uint32_t is correct.
-    for(size_t i = 1; i < 33; i += 4)
+static void StoreWord(const AdcWord& word)
+{
+    const uint8_t bit           = 1 << word.ch_idx;
+    channel_values[word.ch_idx] = word.value;
+    channel_overrange = word.overrange ? channel_overrange | bit
+                                       : channel_overrange & ~bit;
+}
+
+static void UpdateScanTiming(uint32_t timestamp_us)
+{
+    if(timed_scans++ > 0)
     {
-        ch_idx   = spi_rx_buffer[i] >> 4;
-        sign_bit = spi_rx_buffer[i] & 0xf;
+        const float interval
+            = static_cast<float>(timestamp_us - last_scan_time);
+        float& period = scan_timing.period_us;
 
-        if(sign_bit)
+        // Ignore gaps (e.g. the ADC was stopped)
+        if(period == 0.0f)
         {
-            channel_values[ch_idx] = 0;
+            period = interval;
         }
-        else
+        else if(interval < period * 8.0f)
+        {
+            if(timed_scans > kTimingWarmupScans)
+            {
+                scan_timing.max_jitter_us = std::max(
+                    scan_timing.max_jitter_us, fabsf(interval - period));
+            }
+            period += 0.01f * (interval - period);
+        }
+    }
+    last_scan_time = timestamp_us;
+}
+
+// Publishes channel_values[] as the newest scan
+static void PublishScan(uint8_t fresh, uint32_t timestamp_us)
+{
+    AdcMCP3564R::ScanFrame& frame = latest_scan.Back();
+
+    // Channels missing from this scan keep their last value
+    std::copy(channel_values, channel_values + NUM_ADC_CHANNELS, frame.values);
+    frame.timestamp_us = timestamp_us;
+    frame.fresh        = fresh;
+    frame.overrange    = channel_overrange;
+    frame.sequence     = ++scan_sequence;
+    latest_scan.Publish();
+    fresh_channels = fresh_channels | fresh;
+
+    if(!scan_frames.Push(frame))
+    {
+        dropped_frames = dropped_frames + 1;
+    }
+    UpdateScanTiming(timestamp_us);
+}
+
+void endCallback_(void* state, daisy::SpiHandle::Result res)
+{
+    const uint32_t start        = daisy::System::GetTick();
+    const uint32_t timestamp_us = daisy::System::GetUs();
+    scan_timing.interrupts++;
+    transfer_active = false;
+
+    AdcWord words[kBurstWords];
+    DecodeWords(&spi_rx_buffer[1], kBurstWords, scan_order.channels, words);
+
+    // Up to the first word out of place, see WalkBurst()
+    uint32_t take;
+    if(WalkBurst(words, kBurstWords, scan_order, take) < kBurstWords)
+    {
+        sync_errors = sync_errors + 1;
+    }
+
+    uint8_t fresh = 0;
+    for(size_t i = 0; i < kBurstWords; i++)
+    {
+        if(take & (1u << i))
         {
-            channel_values[ch_idx] = spi_rx_buffer[i + 1] << 16
-                                     | spi_rx_buffer[i + 2] << 8
-                                     | spi_rx_buffer[i + 3];
+            StoreWord(words[i]);
+            fresh |= 1 << words[i].ch_idx;
         }
     }
+    PublishScan(fresh, timestamp_us);
+    scan_timing.busy_ticks += daisy::System::GetTick() - start;
 }
 
 daisy::SpiHandle::Result AdcMCP3564R::FetchConvertedDataDMA()
@@ -418,8 +626,218 @@ daisy::SpiHandle::Result AdcMCP3564R::FetchConvertedDataDMA()
     spi_tx_buffer[0] = kDeviceAddress | (kRegAdcData << 2)
                        | AdcMCP3564R::CommandType::STATIC_READ;
 
+    const uint32_t start = daisy::System::GetTick();
+    scan_timing.interrupts++;
+    if(configuring)
+    {
+        return daisy::SpiHandle::Result::ERR;
+    }
+
+    transfer_active              = true;
     daisy::SpiHandle::Result res = spi_handle_.DmaTransmitAndReceive(
         spi_tx_buffer, spi_rx_buffer, size, nullptr, endCallback_, nullptr);
+    if(res != daisy::SpiHandle::Result::OK)
+    {
+        transfer_active = false;
+    }
 
+    scan_timing.busy_ticks += daisy::System::GetTick() - start;
     return res;
+}
+
+/*
+    Takes every word that is complete in the half of the buffer DMA just
+    finished (see AdcWordStream). A scan is published once every channel
+    is in, or early if a channel comes round again before that. Words are
+    timed by their place in the stream, which TIM7 clocks exactly, rather
+    than by when this runs.
+*/
+static void ProcessStream(DMA_HandleTypeDef* /*hdma*/)
+{
+    const uint32_t start = daisy::System::GetTick();
+    scan_timing.interrupts++;
+    stream_received += kStreamHalfBytes;
+
+    for(;;)
+    {
+        AdcWord                   word;
+        const AdcWordStream::Step step = stream_words.Next(
+            stream_rx_buffer, kStreamBytes, stream_received, scan_order, word);
+        if(step == AdcWordStream::NEED_BYTES)
+        {
+            break;
+        }
+        if(step == AdcWordStream::LOST_SYNC)
+        {
+            sync_errors = sync_errors + 1;
+            continue;
+        }
+
+        const uint8_t ch_idx = word.ch_idx;
+        if(stream_fresh & (1 << ch_idx))
+        {
+            PublishScan(stream_fresh, stream_scan_time);
+            stream_fresh = 0;
+        }
+        StoreWord(word);
+        stream_fresh |= 1 << ch_idx;
+        stream_scan_time
+            = stream_start_us + stream_words.Position() * kStreamBytePeriodUs;
+
+        if(stream_fresh == (1 << NUM_ADC_CHANNELS) - 1)
+        {
+            PublishScan(stream_fresh, stream_scan_time);
+            stream_fresh = 0;
+        }
+    }
+    scan_timing.busy_ticks += daisy::System::GetTick() - start;
+}
+
+AdcMCP3564R::Result AdcMCP3564R::StartStreaming()
+{
+    if(streaming_)
+    {
+        return AdcMCP3564R::Result::OK;
+    }
+
+    // Only the first byte is a command. The ADC ignores MOSI for as long
+    // as the read goes on, so the rest of the buffer is never looked at.
+    std::fill(&stream_tx_buffer[0], &stream_tx_buffer[kStreamBytes], 0);
+    stream_tx_buffer[0] = kDeviceAddress | (kRegAdcData << 2)
+                          | AdcMCP3564R::CommandType::STATIC_READ;
+
+    __HAL_RCC_DMA2_CLK_ENABLE();
+    __HAL_RCC_TIM7_CLK_ENABLE();
+
+    // SPI1 RX into the circular buffer, interrupting at half and full
+    stream_rx_dma.Instance                 = DMA2_Stream4;
+    stream_rx_dma.Init.Request             = DMA_REQUEST_SPI1_RX;
+    stream_rx_dma.Init.Direction           = DMA_PERIPH_TO_MEMORY;
+    stream_rx_dma.Init.PeriphInc           = DMA_PINC_DISABLE;
+    stream_rx_dma.Init.MemInc              = DMA_MINC_ENABLE;
+    stream_rx_dma.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+    stream_rx_dma.Init.MemDataAlignment    = DMA_MDATAALIGN_BYTE;
+    stream_rx_dma.Init.Mode                = DMA_CIRCULAR;
+    stream_rx_dma.Init.Priority            = DMA_PRIORITY_HIGH;
+    stream_rx_dma.Init.FIFOMode            = DMA_FIFOMODE_DISABLE;
+
+    // TX paced by the TIM7 update request instead of SPI1's own
+    stream_tx_dma.Instance       = DMA2_Stream5;
+    stream_tx_dma.Init           = stream_rx_dma.Init;
+    stream_tx_dma.Init.Request   = DMA_REQUEST_TIM7_UP;
+    stream_tx_dma.Init.Direction = DMA_MEMORY_TO_PERIPH;
+    stream_tx_dma.Init.Priority  = DMA_PRIORITY_MEDIUM;
+
+    if(HAL_DMA_Init(&stream_rx_dma) != HAL_OK
+       || HAL_DMA_Init(&stream_tx_dma) != HAL_OK)
+    {
+        return AdcMCP3564R::Result::ERR;
+    }
+    stream_rx_dma.XferHalfCpltCallback = ProcessStream;
+    stream_rx_dma.XferCpltCallback     = ProcessStream;
+
+    // Timers on APB1 run at twice PCLK1
+    stream_timer.Instance = TIM7;
+    stream_timer.Init.Prescaler
+        = (2 * daisy::System::GetPClk1Freq()) / 1000000 - 1;
+    stream_timer.Init.CounterMode       = TIM_COUNTERMODE_UP;
+    stream_timer.Init.Period            = kStreamBytePeriodUs - 1;
+    stream_timer.Init.AutoReloadPreload = TIM_AUTORELOAD_PRELOAD_ENABLE;
+    if(HAL_TIM_Base_Init(&stream_timer) != HAL_OK)
+    {
+        return AdcMCP3564R::Result::ERR;
+    }
+    __HAL_TIM_ENABLE_DMA(&stream_timer, TIM_DMA_UPDATE);
+
+    stream_words.Reset(1); // after the command byte
+    stream_received = 0;
+    stream_start_us = daisy::System::GetUs();
+    stream_fresh    = 0;
+
+    // One endless transfer (TSIZE 0) keeps chip select low throughout
+    SPI_TypeDef* spi = SPI1;
+    CLEAR_BIT(spi->CR1, SPI_CR1_SPE);
+    MODIFY_REG(spi->CR2, SPI_CR2_TSIZE, 0);
+    CLEAR_BIT(spi->CFG1, SPI_CFG1_TXDMAEN);
+    SET_BIT(spi->CFG1, SPI_CFG1_RXDMAEN);
+
+    HAL_DMA_Start_IT(&stream_rx_dma,
+                     reinterpret_cast<uint32_t>(&spi->RXDR),
+                     reinterpret_cast<uint32_t>(stream_rx_buffer),
+                     kStreamBytes);
+    HAL_DMA_Start(&stream_tx_dma,
+                  reinterpret_cast<uint32_t>(stream_tx_buffer),
+                  reinterpret_cast<uint32_t>(&spi->TXDR),
+                  kStreamBytes);
+
+    SET_BIT(spi->CR1, SPI_CR1_SPE);
+    SET_BIT(spi->CR1, SPI_CR1_CSTART);
+
+    HAL_NVIC_SetPriority(DMA2_Stream4_IRQn, 1, 1);
+    HAL_NVIC_EnableIRQ(DMA2_Stream4_IRQn);
+    HAL_TIM_Base_Start(&stream_timer);
+
+    streaming_ = true;
+    return AdcMCP3564R::Result::OK;
+}
+
+void AdcMCP3564R::StopStreaming()
+{
+    if(!streaming_)
+    {
+        return;
+    }
+
+    HAL_TIM_Base_Stop(&stream_timer);
+    __HAL_TIM_DISABLE_DMA(&stream_timer, TIM_DMA_UPDATE);
+    HAL_NVIC_DisableIRQ(DMA2_Stream4_IRQn);
+
+    HAL_DMA_Abort(&stream_tx_dma);
+    HAL_DMA_Abort(&stream_rx_dma);
+
+    // Hand SPI1 back to SpiHandle the way it left it
+    SPI_TypeDef* spi = SPI1;
+    CLEAR_BIT(spi->CR1, SPI_CR1_SPE);
+    CLEAR_BIT(spi->CFG1, SPI_CFG1_RXDMAEN);
+    spi->IFCR = 0xFF8; // clear every event flag
+
+    streaming_ = false;
+}
+
+void AdcMCP3564R::HandleStreamInterrupt()
+{
+    HAL_DMA_IRQHandler(&stream_rx_dma);
+}
+
+uint32_t AdcMCP3564R::DeliveryDelayUs() const
+{
+    // The last word of a scan waits at most one half buffer, after the
+    // copy that confirms it
+    return streaming_ ? (kStreamHalfBytes + 8) * kStreamBytePeriodUs : 0;
+}
+
+AdcMCP3564R::ScanTiming AdcMCP3564R::GetScanTiming()
+{
+    return scan_timing;
+}
+
+void AdcMCP3564R::ResetScanTiming()
+{
+    scan_timing = {};
+    timed_scans = 0;
+}
+
+uint32_t AdcMCP3564R::GetSyncErrors()
+{
+    return sync_errors;
+}
+
+uint8_t AdcMCP3564R::TakeFreshChannels()
+{
+    // Atomic against PublishScan() since that only ever runs in between
+    __disable_irq();
+    const uint8_t fresh = fresh_channels;
+    fresh_channels      = 0;
+    __enable_irq();
+    return fresh;
 }
\ No newline at end of file
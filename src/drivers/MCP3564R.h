@@ -2,6 +2,9 @@
 
 #include "daisy.h"
 
+#include "src/double_buffer.h"
+#include "src/spsc_queue.h"
+
 class AdcMCP3564R
 {
   public:
@@ -140,6 +143,99 @@ class AdcMCP3564R
         CH0                     = 0b0000, // CH0
     };
 
+    static constexpr uint8_t kNumChannels = 8;
+
+    /** Writable registers CONFIG0 to SCAN, in device order */
+    struct Registers
+    {
+        uint8_t config[CONFIG_LAST - CONFIG0];
+        uint8_t irq;
+        uint8_t mux;
+        uint8_t scan[3]; // DLY, then SCAN_CH, most significant byte first
+    };
+
+    /**
+    Stages register changes against the driver's shadow copy. Nothing is
+    sent until Commit(), which writes the registers from the first to the
+    last that changed in one incremental write and checks them with one
+    incremental read:
+
+        adc.Configure()
+            .SetOversamplingRatio(AdcMCP3564R::OSR_2048)
+            .SetScanRegister(AdcMCP3564R::SCAN_DELAY_0, 0xff)
+            .Commit();
+    */
+    class Config
+    {
+      public:
+        Config& UseInternalVRef(bool ref);
+        Config& SetClock(AdcMCP3564R::ClkSel clk);
+        Config& SetAMCLKPrescaler(AdcMCP3564R::AMCLKSel clkps);
+        Config& SetOversamplingRatio(AdcMCP3564R::OSRSel sr);
+        Config& SetBoost(AdcMCP3564R::BoostSel boost);
+        Config& SetConversionMode(AdcMCP3564R::ConversionMode mode);
+        Config& SetADCMode(AdcMCP3564R::ADCMode mode);
+        Config& SetMuxReg(AdcMCP3564R::MuxMode msb, AdcMCP3564R::MuxMode lsb);
+        Config& SetIRQPin();
+        Config& SetDataFormat(AdcMCP3564R::DataFormats df);
+        Config& SetScanRegister(AdcMCP3564R::ScanDelayTimes scan_delay,
+                                uint16_t                    channels);
+
+        /**
+        Sends the staged registers. Pauses the stream or waits out a
+        running scan read first. ERR if the read-back differs, in which
+        case the shadow holds what the ADC actually has.
+        */
+        AdcMCP3564R::Result Commit();
+
+      private:
+        friend class AdcMCP3564R;
+
+        explicit Config(AdcMCP3564R* adc)
+        : adc_(adc), staged_(adc->shadow_)
+        {
+        }
+
+        Config& SetConfig(AdcMCP3564R::ConfigRegister reg,
+                          uint8_t                     mask,
+                          uint8_t                     bits);
+
+        AdcMCP3564R* adc_;
+        Registers    staged_;
+    };
+
+    /**
+    One decoded scan of every channel, stamped when its read completed.
+    Values are signed 25-bit: +-0x800000 is full scale, and the ADC goes
+    a little past it either way before it clips.
+    */
+    struct ScanFrame
+    {
+        uint32_t sequence; // counts scans from 1; 0 before the first one
+        uint32_t timestamp_us;
+        uint8_t  fresh;     // bit n set if channel n was read in this scan
+        uint8_t  overrange; // bit n set if channel n is past full scale
+        int32_t  values[kNumChannels];
+    };
+
+    /** What the ReadScan() side saw of one channel since Init() */
+    struct ChannelStats
+    {
+        uint32_t stale;   // reads that got no new value for the channel
+        uint32_t dropped; // new values that were never read
+    };
+
+    /** How evenly scans arrive, measured on their timestamps */
+    struct ScanTiming
+    {
+        uint32_t interrupts;    // entries into the driver's interrupt code
+        uint32_t busy_ticks;    // System::GetTick() time spent in them
+        float    period_us;     // average time between two scans
+        float    max_jitter_us; // worst distance of one interval from it
+    };
+
+    using ScanFrameQueue = fourseas::SpscQueue<ScanFrame, 16>;
+
     AdcMCP3564R() {}
 
     ~AdcMCP3564R() {}
@@ -150,6 +246,17 @@ class AdcMCP3564R
 
     uint8_t GetConfig(AdcMCP3564R::ConfigRegister reg);
 
+    /** Starts a batch of register changes from the shadow copy */
+    Config Configure();
+
+    /** Reads CONFIG0 to SCAN from the ADC in one transaction */
+    Result ReadRegisters(Registers& regs);
+
+    /** What the registers were last committed or read back as */
+    const Registers& GetShadow() const { return shadow_; }
+
+    // Single-register shorthands for Configure().Set...().Commit()
+
     void UseInternalVRef(bool ref);
 
     void SetClock(AdcMCP3564R::ClkSel clk);
@@ -179,12 +286,69 @@ class AdcMCP3564R
 
     daisy::SpiHandle::Result FetchConvertedDataDMA();
 
-    uint32_t  Get(uint8_t idx);
-    uint32_t* GetPtr(uint8_t idx);
+    /**
+    Free-running alternative to the data-ready interrupt and
+    FetchConvertedDataDMA(): SPI1 stays selected in one endless static
+    read of ADCDATA, clocked one byte at a time by TIM7 through DMA, into
+    a circular buffer. The CPU only runs at the half and full buffer
+    events, where the words are decoded and split into scans.
+
+    The stream reads a word every 8 us, so the ADC must convert slower
+    than one channel per two words (~62 kHz). No register access while
+    streaming; StopStreaming() first.
+    */
+    Result StartStreaming();
+    void   StopStreaming();
+    bool   IsStreaming() const { return streaming_; }
+
+    /** Call from DMA2_Stream4_IRQHandler() */
+    void HandleStreamInterrupt();
+
+    /** How long a scan can wait in the driver before it is published */
+    uint32_t DeliveryDelayUs() const;
+
+    /**
+    Copies the newest complete scan into `frame`, all channels from the
+    same scan, and updates the channel stats. Only the copy is safe
+    against the driver publishing meanwhile; the stats are not guarded,
+    so there must be one reader, the control tick. Returns false if there
+    was no new scan.
+    */
+    bool ReadScan(ScanFrame& frame);
+
+    const ChannelStats& GetChannelStats(uint8_t idx) const;
+
+    /** Scan frames pushed from the DMA complete callback, oldest first */
+    ScanFrameQueue* GetScanFrames();
+
+    /** Frames dropped because nobody drained the queue in time */
+    uint32_t GetDroppedFrames();
+
+    ScanTiming GetScanTiming();
+    void       ResetScanTiming();
+
+    /**
+    Times a scan read lost its place: a word with a broken SGN nibble, a
+    channel that is not scanned, or channels out of SCAN order. The rest
+    of that read is dropped, and the stream looks for the word boundary
+    again byte by byte.
+    */
+    uint32_t GetSyncErrors();
+
+    /** Channels published since the last call, one bit each */
+    uint8_t TakeFreshChannels();
 
 
   private:
+    // Incremental write / read of the bytes `first` to `last` of
+    // Registers, which must start and end on whole registers
+    Result WriteRegisters(const Registers& regs, size_t first, size_t last);
+    Result ReadRegisters(Registers& regs, size_t first, size_t last);
+
     daisy::SpiHandle spi_handle_;
+    Registers        shadow_;
 
-    uint32_t* val_;
+    bool         streaming_     = false;
+    uint32_t     last_sequence_ = 0;
+    ChannelStats stats_[kNumChannels];
 };
\ No newline at end of file
@@ -0,0 +1,224 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+    Decoding of the MCP3564R's ADCDATA words, shared by the data-ready
+    bursts and the free-running stream in MCP3564R.cc. Nothing here
+    touches the hardware, so it also builds on the host for
+    bench/adc_decode.cc.
+*/
+
+constexpr uint8_t kAdcNumChannels = 8;
+constexpr uint8_t kAdcNoChannel   = 0xff;
+
+/*
+    One DF_32_SIGNED_CHAN word: CHID[3:0], SGN[3:0], then 24 data bits.
+    The value is 25-bit two's complement with bit 24 repeated through the
+    SGN nibble, so +-0x800000 is full scale and anything past it is
+    overrange.
+*/
+struct AdcWord
+{
+    uint32_t raw;
+    int32_t  value;
+    uint8_t  ch_idx;
+    bool     valid;     // SGN holds only sign bits and CHID is scanned
+    bool     overrange; // beyond full scale, either way
+};
+
+/*
+    Channels the SCAN register has on, and which one the ADC converts
+    after each of them, for checking the CHID order
+*/
+struct AdcScanOrder
+{
+    uint8_t channels;
+    uint8_t next[kAdcNumChannels];
+
+    // From SCAN_CH[7:0]. SCAN at 0 is MUX mode, where one channel repeats
+    // and the order is not checked.
+    void Set(uint8_t scan_channels)
+    {
+        for(uint8_t ch = 0; ch < kAdcNumChannels; ch++)
+        {
+            uint8_t following = kAdcNoChannel;
+            for(uint8_t i = 1; i <= kAdcNumChannels && scan_channels != 0;
+                i++)
+            {
+                following = (ch + i) % kAdcNumChannels;
+                if(scan_channels & (1 << following))
+                {
+                    break;
+                }
+            }
+            next[ch] = following;
+        }
+        channels = scan_channels != 0 ? scan_channels : 0xff;
+    }
+};
+
+/*
+    Decodes `count` words in one go. There are no branches and nothing
+    carries from one word to the next, so the loop unrolls and the words
+    pipeline; the order checks run afterwards on the results.
+*/
+inline void DecodeWords(const uint8_t* bytes,
+                        size_t         count,
+                        uint8_t        channels,
+                        AdcWord*       words)
+{
+    for(size_t i = 0; i < count; i++)
+    {
+        const uint8_t* b   = &bytes[4 * i];
+        const uint32_t raw = static_cast<uint32_t>(b[0]) << 24 | b[1] << 16
+                             | b[2] << 8 | b[3];
+        const uint32_t sgn = (raw >> 24) & 0xf;
+
+        words[i].raw       = raw;
+        words[i].value     = static_cast<int32_t>(raw << 7) >> 7;
+        words[i].ch_idx    = raw >> 28;
+        words[i].valid     = (((sgn + 1) & 0xf) <= 1)
+                         & ((channels >> (raw >> 28)) & 1);
+        words[i].overrange = ((raw >> 24) ^ (raw >> 23)) & 1;
+    }
+}
+
+// Whether `word` can follow a word from channel `last` (kAdcNoChannel: no
+// word yet, anything scanned may come)
+inline bool
+InScanOrder(const AdcWord& word, const AdcScanOrder& order, uint8_t last)
+{
+    return word.valid
+           && (last == kAdcNoChannel || order.next[last] == kAdcNoChannel
+               || word.ch_idx == order.next[last]);
+}
+
+/*
+    Walks one burst read (AdcMCP3564R::FetchConvertedDataDMA()), decoded
+    by DecodeWords(). A word repeats until the ADC has a new conversion,
+    which must be from the next scanned channel. Anything else means the
+    read slipped and nothing after it can be trusted; the next read starts
+    aligned on its command byte again.
+
+    Sets bit i of `take` for each word that is a new conversion, and
+    returns how many words were in place: `count` unless the read slipped.
+    At most 32 words.
+*/
+inline size_t WalkBurst(const AdcWord*      words,
+                        size_t              count,
+                        const AdcScanOrder& order,
+                        uint32_t&           take)
+{
+    take         = 0;
+    uint8_t last = kAdcNoChannel;
+    for(size_t i = 0; i < count; i++)
+    {
+        if(i > 0 && words[i].raw == words[i - 1].raw)
+        {
+            continue;
+        }
+        if(!InScanOrder(words[i], order, last))
+        {
+            return i;
+        }
+        take |= 1u << i;
+        last = words[i].ch_idx;
+    }
+    return count;
+}
+
+/*
+    Walks the free-running stream (AdcMCP3564R::StartStreaming()) a word
+    at a time. Each word is the newest conversion, read at least twice; it
+    is taken on its second copy and later copies are skipped. A word out
+    of SCAN order moves the walk along a byte until it finds its footing
+    again.
+
+    Positions count bytes since the stream started. They run free and
+    wrap every 2^32 bytes, so only differences are compared, and the ring
+    size must be a power of two for the wrap to land on its start.
+*/
+class AdcWordStream
+{
+  public:
+    enum Step
+    {
+        WORD,       // `word` is a new conversion
+        LOST_SYNC,  // a word out of order after one that was in order
+        NEED_BYTES, // fewer than 4 bytes in past the position
+    };
+
+    void Reset(uint32_t position)
+    {
+        position_  = position;
+        last_word_ = 0;
+        confirmed_ = false;
+        last_ch_   = kAdcNoChannel;
+    }
+
+    /*
+    Reads on from the position in `ring`, which holds the newest
+    `ring_bytes` of the `received` bytes in so far
+    */
+    Step Next(const uint8_t*      ring,
+              size_t              ring_bytes,
+              uint32_t            received,
+              const AdcScanOrder& order,
+              AdcWord&            word)
+    {
+        while(static_cast<int32_t>(received - position_) >= 4)
+        {
+            uint8_t bytes[4];
+            for(size_t i = 0; i < 4; i++)
+            {
+                bytes[i] = ring[(position_ + i) % ring_bytes];
+            }
+            position_ += 4;
+
+            DecodeWords(bytes, 1, order.channels, &word);
+            if(word.raw != last_word_)
+            {
+                last_word_ = word.raw;
+                confirmed_ = false;
+
+                // Lost the word boundary (e.g. an overrun dropped a
+                // byte): try one byte further on, and take the next good
+                // word as a new start
+                if(!InScanOrder(word, order, last_ch_))
+                {
+                    const bool was_in_sync = last_ch_ != kAdcNoChannel;
+                    position_ -= 3;
+                    last_ch_ = kAdcNoChannel;
+                    if(was_in_sync)
+                    {
+                        return LOST_SYNC;
+                    }
+                }
+                continue;
+            }
+
+            // Every conversion is read at least twice, so a word is only
+            // taken once its copy confirms it. A byte missing from the
+            // data alone would not show in the word itself.
+            if(confirmed_)
+            {
+                continue;
+            }
+            confirmed_ = true;
+            last_ch_   = word.ch_idx;
+            return WORD;
+        }
+        return NEED_BYTES;
+    }
+
+    // Just past the last word read
+    uint32_t Position() const { return position_; }
+
+  private:
+    uint32_t position_;  // first byte of the next word
+    uint32_t last_word_; // repeats of it are the same conversion
+    bool     confirmed_; // that word has been read twice
+    uint8_t  last_ch_;   // channel of the last word taken
+};
@@ -1,24 +1,39 @@
 #include <algorithm>
 #include <array>
 #include "daisy.h"
+#include "util/scopedirqblocker.h"
 
 #include "daisy_seed.h"
 #include "TLC59116.h"
 
-constexpr daisy::Pin PIN_I2C1_SCL = daisy::seed::D11;
-constexpr daisy::Pin PIN_I2C1_SDA = daisy::seed::D12;
-
 constexpr size_t BUFFER_SIZE = 17;
 
 static uint8_t DMA_BUFFER_MEM_SECTION tlc59116_i2c_tx_buffer[3][BUFFER_SIZE];
 
 
-void TLC59116::Init()
+void TLC59116::Init(I2CBus *bus)
 {
-    i2c_addr_[0]        = 0b1100000; // 0x60?
-    i2c_addr_[1]        = 0b1100001; // 0x61?
-    i2c_addr_[2]        = 0b1100010; // 0x62?
-    current_device_idx_ = 0;
+    bus_            = bus;
+    i2c_addr_[0]    = 0b1100000; // 0x60?
+    i2c_addr_[1]    = 0b1100001; // 0x61?
+    i2c_addr_[2]    = 0b1100010; // 0x62?
+    frames_pending_ = 0;
+
+    // Everything goes out with the first frame
+    for(auto &levels : levels_)
+    {
+        std::fill(&levels[0], &levels[kNumChannels], 0);
+    }
+    std::fill(&dirty_[0], &dirty_[kNumChips], 0xffff);
+    std::fill(&resend_[0], &resend_[kNumChips], 0);
+    for(Frame &frame : frames_)
+    {
+        frame.owner = this;
+        frame.sent  = 0;
+    }
+    last_frame_us_ = daisy::System::GetUs() - kFramePeriodUs;
+    writes_        = 0;
+    bytes_         = 0;
 
     // Zero-out buffer
     for(auto &buffer : tlc59116_i2c_tx_buffer)
@@ -26,17 +41,6 @@ void TLC59116::Init()
         std::fill(&buffer[0], &buffer[BUFFER_SIZE - 1], 0);
     }
 
-    daisy::I2CHandle::Config i2c_config;
-
-    i2c_config.periph = daisy::I2CHandle::Config::Peripheral::I2C_1;
-
-    i2c_config.speed          = daisy::I2CHandle::Config::Speed::I2C_1MHZ;
-    i2c_config.mode           = daisy::I2CHandle::Config::Mode::I2C_MASTER;
-    i2c_config.pin_config.scl = PIN_I2C1_SCL;
-    i2c_config.pin_config.sda = PIN_I2C1_SDA;
-
-    i2c_handle_.Init(i2c_config);
-
     static constexpr uint16_t size    = 2;
     static constexpr uint32_t timeout = 10000;
 
@@ -46,23 +50,23 @@ void TLC59116::Init()
 
     uint8_t payload[2] = {reg, data};
 
-    i2c_handle_.TransmitBlocking(default_allcall_, payload, size, timeout);
+    bus_->TransmitBlocking(default_allcall_, payload, size, timeout);
 
     payload[0] = TLC59116::LEDOUT0;
     payload[1] = 0xFF;
-    i2c_handle_.TransmitBlocking(default_allcall_, payload, size, timeout);
+    bus_->TransmitBlocking(default_allcall_, payload, size, timeout);
 
     payload[0] = TLC59116::LEDOUT1;
     payload[1] = 0xFF;
-    i2c_handle_.TransmitBlocking(default_allcall_, payload, size, timeout);
+    bus_->TransmitBlocking(default_allcall_, payload, size, timeout);
 
     payload[0] = TLC59116::LEDOUT2;
     payload[1] = 0xFF;
-    i2c_handle_.TransmitBlocking(default_allcall_, payload, size, timeout);
+    bus_->TransmitBlocking(default_allcall_, payload, size, timeout);
 
     payload[0] = TLC59116::LEDOUT3;
     payload[1] = 0xFF;
-    i2c_handle_.TransmitBlocking(default_allcall_, payload, size, timeout);
+    bus_->TransmitBlocking(default_allcall_, payload, size, timeout);
 
     // Apply global brightness control (roughly 30% of max)
     // power target, under 300mA
@@ -71,24 +75,99 @@ void TLC59116::Init()
     //payload[1] = 0xFF; // full power
 
 
-    i2c_handle_.TransmitBlocking(default_allcall_, payload, size, timeout);
+    bus_->TransmitBlocking(default_allcall_, payload, size, timeout);
 }
 
 void TLC59116::Set(uint8_t idx, uint8_t level)
 {
     uint8_t buff_idx = idx / 16;
     idx -= (buff_idx * 16);
-    tlc59116_i2c_tx_buffer[buff_idx][idx + 1] = level;
+    if(levels_[buff_idx][idx] != level)
+    {
+        levels_[buff_idx][idx] = level;
+        dirty_[buff_idx] |= 1 << idx;
+    }
 }
 
 void TLC59116::Transmit()
 {
     static constexpr uint8_t reg = TLC59116::PWM0;
 
-    tlc59116_i2c_tx_buffer[current_device_idx_][0] = (0b101 << 5) | reg;
-    i2c_handle_.TransmitDma(i2c_addr_[current_device_idx_],
-                            tlc59116_i2c_tx_buffer[current_device_idx_],
-                            BUFFER_SIZE,
-                            endCallback_,
-                            this);
+    const uint32_t now = daisy::System::GetUs();
+    if(frames_pending_ > 0 || now - last_frame_us_ < kFramePeriodUs)
+    {
+        return;
+    }
+
+    // No frame is out, so no callback can touch resend_ meanwhile
+    uint8_t chips = 0;
+    for(uint8_t device_idx = 0; device_idx < kNumChips; device_idx++)
+    {
+        dirty_[device_idx] |= resend_[device_idx];
+        resend_[device_idx] = 0;
+        chips += dirty_[device_idx] != 0 ? 1 : 0;
+    }
+    if(chips == 0)
+    {
+        return;
+    }
+
+    // Counted up front, so a frame that finishes before the next one is
+    // queued cannot bring the count to 0 early
+    frames_pending_ = chips;
+    last_frame_us_  = now;
+    for(uint8_t device_idx = 0; device_idx < kNumChips; device_idx++)
+    {
+        const uint16_t dirty = dirty_[device_idx];
+        if(dirty == 0)
+        {
+            continue;
+        }
+        const uint8_t first = __builtin_ctz(dirty);
+        const uint8_t last  = 31 - __builtin_clz(dirty);
+
+        // Only touched while no frame is on the bus
+        uint8_t *buffer = tlc59116_i2c_tx_buffer[device_idx];
+        buffer[0]       = (0b101 << 5) | (reg + first);
+        std::copy(&levels_[device_idx][first],
+                  &levels_[device_idx][last + 1],
+                  &buffer[1]);
+
+        I2CBus::Transaction frame;
+        frame.direction = I2CBus::Direction::TRANSMIT;
+        frame.address   = i2c_addr_[device_idx];
+        frame.data      = buffer;
+        frame.size      = 2 + last - first;
+        frame.callback  = endCallback_;
+        frame.context   = &frames_[device_idx];
+
+        frames_[device_idx].sent = dirty;
+        if(bus_->Submit(I2CBus::PRIORITY_LOW, frame))
+        {
+            dirty_[device_idx] = 0;
+            writes_++;
+            bytes_ += frame.size;
+        }
+        else
+        {
+            daisy::ScopedIrqBlocker irq_blocker;
+            frames_pending_ = frames_pending_ - 1;
+        }
+    }
+}
+
+void TLC59116::endCallback_(void *context, daisy::I2CHandle::Result result)
+{
+    Frame    *frame    = static_cast<Frame *>(context);
+    TLC59116 *instance = frame->owner;
+
+    // Failed or timed out: the chip still has the old levels, so those
+    // channels go out again with the next frame
+    if(result != daisy::I2CHandle::Result::OK)
+    {
+        const size_t device_idx = frame - instance->frames_;
+        instance->resend_[device_idx]
+            = instance->resend_[device_idx] | frame->sent;
+    }
+    instance->frames_pending_ = instance->frames_pending_ - 1;
 }
@@ -2,6 +2,8 @@
 
 #include "daisy.h"
 
+#include "I2CBus.h"
+
 class TLC59116
 {
   public:
@@ -43,25 +45,59 @@ class TLC59116
     TLC59116() {}
     ~TLC59116() {}
 
-    void Init();
+    /** At most this often a frame goes out, ~60 Hz */
+    static constexpr uint32_t kFramePeriodUs = 1000000 / 60;
+
+    /** Sets the chips up, blocking; before `bus` has anything queued */
+    void Init(I2CBus *bus);
+
+    /** Takes a new level; only a change marks anything to send */
     void Set(uint8_t idx, uint8_t level);
+
+    /**
+    Queues what changed since the last frame: per chip, one auto-increment
+    write across the PWM registers from the first changed one to the last.
+    Nothing is sent when nothing changed, while the last frame is still
+    going out, or within kFramePeriodUs of it; changes stay marked for the
+    next call, so keep calling.
+    */
     void Transmit();
 
+    /** True while some change is still waiting for a Transmit() */
+    bool Changed() const
+    {
+        return (dirty_[0] | dirty_[1] | dirty_[2] | resend_[0] | resend_[1]
+                | resend_[2])
+               != 0;
+    }
+
+    /** Chip writes queued since Init(), and the bytes in them */
+    uint32_t GetWrites() const { return writes_; }
+    uint32_t GetBytes() const { return bytes_; }
+
   private:
-    uint8_t          i2c_addr_[3];
-    daisy::I2CHandle i2c_handle_;
+    static constexpr size_t kNumChips    = 3;
+    static constexpr size_t kNumChannels = 16;
+
+    uint8_t          i2c_addr_[kNumChips];
+    I2CBus          *bus_;
     uint8_t          default_allcall_ = 0b1101000; // 0x68
-    uint8_t          current_device_idx_;
+    volatile uint8_t frames_pending_;
 
-    void static endCallback_(void *context, daisy::I2CHandle::Result result)
+    // What is on the bus for one chip, and the context of its callback
+    struct Frame
     {
-        TLC59116 *instance = static_cast<TLC59116 *>(context);
-        if(instance->current_device_idx_ >= 3)
-        {
-            instance->current_device_idx_ = 0;
-            return;
-        }
-        instance->current_device_idx_++;
-        instance->Transmit();
-    }
+        TLC59116 *owner;
+        uint16_t  sent; // bit n: PWMn is in the frame
+    };
+
+    uint8_t           levels_[kNumChips][kNumChannels];
+    uint16_t          dirty_[kNumChips];  // bit n: PWMn differs from the chip
+    volatile uint16_t resend_[kNumChips]; // from frames that failed
+    Frame             frames_[kNumChips];
+    uint32_t          last_frame_us_;
+    uint32_t          writes_;
+    uint32_t          bytes_;
+
+    void static endCallback_(void *context, daisy::I2CHandle::Result result);
 };
\ No newline at end of file
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <algorithm>
+#include <stddef.h>
+
+namespace fourseas
+{
+// Non-zero taps of Kaiser-windowed halfband filters, from the centre
+// outwards (offsets 1, 3, 5, ...). The centre tap is always 0.5.
+
+// 2x -> 1x at 48 kHz: flat to 18 kHz, -70 dB from 30 kHz
+static constexpr float kHalfband39[10] = {
+    3.154507816e-01f,
+    -9.782140060e-02f,
+    5.068020681e-02f,
+    -2.886926090e-02f,
+    1.639655120e-02f,
+    -8.843228667e-03f,
+    4.345518045e-03f,
+    -1.840500755e-03f,
+    6.006988240e-04f,
+    -9.936550822e-05f,
+};
+
+// 4x -> 2x: only has to clear what would fold below 18 kHz after the
+// second stage, so the transition band is wide. -52 dB from 76 kHz.
+static constexpr float kHalfband15[4] = {
+    2.978023393e-01f,
+    -5.693043646e-02f,
+    9.397768383e-03f,
+    -2.696711921e-04f,
+};
+
+/**
+    Polyphase halfband FIR that halves the sample rate.
+
+    Every other tap of a halfband filter is zero apart from the centre one,
+    so the input is split into even and odd phases: the odd phase only
+    meets the centre tap, and the even phase is folded around the centre to
+    use the symmetry. That makes `half_taps` multiplies per output sample.
+    \tparam half_taps number of non-zero taps on each side of the centre
+*/
+template <size_t half_taps>
+class HalfbandDecimator
+{
+  public:
+    HalfbandDecimator() {}
+    ~HalfbandDecimator() {}
+
+    void Init(const float* coefficients)
+    {
+        coefficients_ = coefficients;
+        Reset();
+    }
+
+    void Reset()
+    {
+        std::fill(&even_[0], &even_[2 * kEvenLength], 0.0f);
+        std::fill(&odd_[0], &odd_[2 * kOddLength], 0.0f);
+        even_head_ = 0;
+        odd_head_  = 0;
+    }
+
+    /** Takes two consecutive input samples, oldest first */
+    inline float Process(float a, float b)
+    {
+        // Histories are written twice so the taps can be read contiguously,
+        // newest sample first.
+        even_head_ = (even_head_ == 0 ? kEvenLength : even_head_) - 1;
+        odd_head_  = (odd_head_ == 0 ? kOddLength : odd_head_) - 1;
+        even_[even_head_] = even_[even_head_ + kEvenLength] = b;
+        odd_[odd_head_] = odd_[odd_head_ + kOddLength] = a;
+
+        const float* even = &even_[even_head_];
+        float        sum  = 0.5f * odd_[odd_head_ + half_taps - 1];
+        for(size_t k = 0; k < half_taps; k++)
+        {
+            sum += coefficients_[k]
+                   * (even[half_taps - 1 - k] + even[half_taps + k]);
+        }
+        return sum;
+    }
+
+  private:
+    static constexpr size_t kEvenLength = 2 * half_taps;
+    static constexpr size_t kOddLength  = half_taps;
+
+    const float* coefficients_;
+
+    float  even_[2 * kEvenLength];
+    float  odd_[2 * kOddLength];
+    size_t even_head_;
+    size_t odd_head_;
+};
+
+} // namespace fourseas
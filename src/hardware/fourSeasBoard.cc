@@ -50,9 +50,8 @@ void FourSeasHW::Init(bool boost)
 
     InitAudio();
 
-    // This applies settings to both CODECs
-    seed.SetAudioBlockSize(24);
-    seed.SetAudioSampleRate(daisy::SaiHandle::Config::SampleRate::SAI_48KHZ);
+    // Until the SD card has been read and ConfigureAudio() called again
+    ConfigureAudio(AudioConfig::FromProfile(AudioConfig::DEFAULT));
 
     InitAnalogInputs();
     InitExtADC();
@@ -63,6 +62,8 @@ void FourSeasHW::Init(bool boost)
     HAL_NVIC_SetPriority(SPI1_IRQn, 1, 1);
     HAL_NVIC_SetPriority(I2C1_EV_IRQn, 1, 1);
 
+    InitPanelI2C();
+    buttons.Init();
 
 #ifdef TESTING_FIRMWARE
     // InitLEDDriver();  // Commented out for testing
@@ -75,9 +76,23 @@ void FourSeasHW::Init(bool boost)
 
 void FourSeasHW::SetHidUpdateRates()
 {
+    // Every control that InitAnalogInputs() and InitADCCVs() set up at the
+    // callback rate; anything reading through a Parameter holds a copy and
+    // needs re-initialising after this
+    const float rate = AudioCallbackRate();
     for(size_t i = 0; i < KNOB_LAST; i++)
     {
-        knobs[i].SetSampleRate(AudioCallbackRate());
+        knobs[i].SetSampleRate(rate);
+    }
+    for(size_t i = 0; i < ONBOARD_CV_LAST; i++)
+    {
+        cv[i].SetSampleRate(rate);
+    }
+    rotary_switch.SetSampleRate(rate);
+    extra_knob.SetSampleRate(rate);
+    for(size_t i = 0; i < ADC_CV_LAST; i++)
+    {
+        adc_cvs[i].SetSampleRate(rate);
     }
 }
 
@@ -114,11 +129,13 @@ void FourSeasHW::RefreshWatchdog()
 void FourSeasHW::StartAudio(daisy::AudioHandle::InterleavingAudioCallback cb)
 {
     seed.StartAudio(cb);
+    audio_running_ = true;
 }
 
 void FourSeasHW::StartAudio(daisy::AudioHandle::AudioCallback cb)
 {
     seed.StartAudio(cb);
+    audio_running_ = true;
 }
 
 void FourSeasHW::ChangeAudioCallback(
@@ -135,6 +152,20 @@ void FourSeasHW::ChangeAudioCallback(daisy::AudioHandle::AudioCallback cb)
 void FourSeasHW::StopAudio()
 {
     seed.StopAudio();
+    audio_running_ = false;
+}
+
+void FourSeasHW::ConfigureAudio(const AudioConfig& config)
+{
+    audio_config_ = config;
+
+    // This applies settings to both CODECs
+    seed.SetAudioSampleRate(
+        config.sample_rate > 48000.0f
+            ? daisy::SaiHandle::Config::SampleRate::SAI_96KHZ
+            : daisy::SaiHandle::Config::SampleRate::SAI_48KHZ);
+    seed.SetAudioBlockSize(config.block_size);
+    SetHidUpdateRates();
 }
 
 void FourSeasHW::SetAudioBlockSize(size_t size)
@@ -175,22 +206,6 @@ void FourSeasHW::StopAdc()
     seed.adc.Stop();
 }
 
-void FourSeasHW::ProcessAnalogControls()
-{
-    for(auto &knob : knobs)
-    {
-        knob.Process();
-    }
-
-    cv[ONBOARD_CV_0].Process();
-    cv[ONBOARD_CV_1].Process();
-
-    for(auto &adc_cv : adc_cvs)
-    {
-        adc_cv.Process();
-    }
-}
-
 void FourSeasHW::UpdateLEDs()
 {
     led_driver.Transmit();
@@ -198,24 +213,19 @@ void FourSeasHW::UpdateLEDs()
 
 void FourSeasHW::InitLEDDriver()
 {
-    led_driver.Init();
+    led_driver.Init(&panel_i2c_);
 }
 
 void FourSeasHW::UpdateExtGPIO()
 {
-    uint8_t state = ext_gpio_.Fetch();
+    // What the read started on the last call brought in; the buttons run
+    // one poll (~3 ms) behind, and nothing here waits on I2C
+    panel_i2c_.Service();
 
-    for(size_t i = 0; i < BUTTON_LAST; i++)
-    {
-        uint16_t *button_state = buttons[i].GetState();
+    uint8_t state = ext_gpio_.GetState();
+    ext_gpio_.StartFetch();
 
-        *button_state = *button_state << 1;
-        if(state & (1 << i))
-        {
-            *button_state |= 1;
-        }
-        buttons[i].UpdateTimestamp();
-    }
+    buttons.Process(state, daisy::System::GetUs());
 }
 
 daisy::SpiHandle::Result FourSeasHW::UpdateExtADC()
@@ -223,6 +233,11 @@ daisy::SpiHandle::Result FourSeasHW::UpdateExtADC()
     return adc_.FetchConvertedDataDMA();
 }
 
+void FourSeasHW::LatchExtADC()
+{
+    adc_.ReadScan(adc_frame_);
+}
+
 void FourSeasHW::InitAnalogInputs()
 {
     daisy::AdcChannelConfig adc_init[ANALOG_LAST];
@@ -263,9 +278,11 @@ void FourSeasHW::InitAnalogInputs()
 
 void FourSeasHW::InitADCCVs()
 {
+    // The controls read the latched frame, never the live DMA decode
+    adc_frame_ = {};
     for(size_t i = 0; i < ADC_CV_LAST; i++)
     {
-        adc_cvs[i].InitBipolarCv(adc_.GetPtr(i), AudioCallbackRate());
+        adc_cvs[i].InitBipolarCv(&adc_frame_.values[i], AudioCallbackRate());
     }
 }
 
@@ -298,7 +315,7 @@ void FourSeasHW::InitAudio()
      *  Audio will clip at -2 to 2, and result 20Vpp output.
      */
     daisy::AudioHandle::Config audio_cfg;
-    audio_cfg.blocksize  = 48;
+    audio_cfg.blocksize  = kAudioBlockSize;
     audio_cfg.samplerate = daisy::SaiHandle::Config::SampleRate::SAI_48KHZ;
     audio_cfg.postgain   = 1.0f;
 
@@ -311,14 +328,6 @@ void FourSeasHW::InitExtADC()
     adc_.Init();
 
     adc_.ResetDefaults();
-    adc_.UseInternalVRef(false);
-
-    adc_.SetClock(AdcMCP3564R::ClkSel::EXT_CLK);
-
-    adc_.SetConversionMode(AdcMCP3564R::ConversionMode::CONTINUOUS);
-    adc_.SetADCMode(AdcMCP3564R::ADCMode::ADC_CONVERT);
-
-    adc_.SetBoost(AdcMCP3564R::BoostSel::BOOST_2);
 
     // OSR_1024 IRQs at ~2.4k and is about the max we can handle
     // OSR_2048 clocks @ 1.6k if we want some breathing room
@@ -330,11 +339,17 @@ void FourSeasHW::InitExtADC()
     // OSR_512 max: 9600, actual: ~3.2kHz
     // OSR_1024 max: 4800, actual: ~2.4kHz
 
-    adc_.SetOversamplingRatio(AdcMCP3564R::OSRSel::OSR_2048);
-
-    adc_.SetDataFormat(AdcMCP3564R::DataFormats::DF_32_SIGNED_CHAN);
-
-    adc_.SetScanRegister(AdcMCP3564R::ScanDelayTimes::SCAN_DELAY_0, 0xff);
+    // One write and one read-back for the whole setup
+    adc_.Configure()
+        .UseInternalVRef(false)
+        .SetClock(AdcMCP3564R::ClkSel::EXT_CLK)
+        .SetConversionMode(AdcMCP3564R::ConversionMode::CONTINUOUS)
+        .SetADCMode(AdcMCP3564R::ADCMode::ADC_CONVERT)
+        .SetBoost(AdcMCP3564R::BoostSel::BOOST_2)
+        .SetOversamplingRatio(AdcMCP3564R::OSRSel::OSR_2048)
+        .SetDataFormat(AdcMCP3564R::DataFormats::DF_32_SIGNED_CHAN)
+        .SetScanRegister(AdcMCP3564R::ScanDelayTimes::SCAN_DELAY_0, 0xff)
+        .Commit();
 
     // Setup ADC IRQ pinout
     // TODO: wrap these naked HAL calls to make more idiomatic
@@ -348,7 +363,20 @@ void FourSeasHW::InitExtADC()
 
 void FourSeasHW::InitExtGPIO()
 {
-    ext_gpio_.Init(0b0100000);
+    ext_gpio_.Init(&panel_i2c_, 0b0100000);
+}
+
+void FourSeasHW::InitPanelI2C()
+{
+    daisy::I2CHandle::Config i2c_config;
+
+    i2c_config.periph         = daisy::I2CHandle::Config::Peripheral::I2C_1;
+    i2c_config.speed          = daisy::I2CHandle::Config::Speed::I2C_1MHZ;
+    i2c_config.mode           = daisy::I2CHandle::Config::Mode::I2C_MASTER;
+    i2c_config.pin_config.scl = PIN_I2C1_SCL;
+    i2c_config.pin_config.sda = PIN_I2C1_SDA;
+
+    panel_i2c_.Init(i2c_config);
 }
 
 void FourSeasHW::InitExtI2C()
@@ -6,10 +6,12 @@
 #include "daisy_seed.h"
 #endif // ifndef UNIT_TEST
 
+#include "src/audio_config.h"
 #include "src/button.h"
 #include "src/analog_ctrl_24.h"
 #include "src/cal_input.h"
 
+#include "src/drivers/I2CBus.h"
 #include "src/drivers/MCP23008.h"
 #include "src/drivers/MCP3564R.h"
 #include "src/drivers/TLC59116.h"
@@ -104,14 +106,18 @@ class FourSeasHW
     void ChangeAudioCallback(daisy::AudioHandle::InterleavingAudioCallback cb);
     void ChangeAudioCallback(daisy::AudioHandle::AudioCallback cb);
     void StopAudio();
+    /** Between StartAudio() and StopAudio() */
+    bool AudioRunning() const { return audio_running_; }
     void SetAudioBlockSize(size_t size);
+    /** Applies rate and block size to both codecs. Audio must be stopped. */
+    void               ConfigureAudio(const AudioConfig& config);
+    const AudioConfig& GetAudioConfig() const { return audio_config_; }
     size_t AudioBlockSize();
     void   SetAudioSampleRate(daisy::SaiHandle::Config::SampleRate samplerate);
     float  AudioSampleRate();
     float  AudioCallbackRate();
     void   StartAdc();
     void   StopAdc();
-    void   ProcessAnalogControls();
     void   InitLEDDriver();
     void   InitExtGPIO();
     void   UpdateLEDs();
@@ -122,6 +128,14 @@ class FourSeasHW
     void     RefreshWatchdog();
 
     daisy::SpiHandle::Result UpdateExtADC();
+    /**
+    Takes the newest whole ADC scan for adc_cvs; once per control tick.
+    Not reentrant: while audio runs only the callback may call it.
+    */
+    void LatchExtADC();
+
+    /** I2C1, shared by the LED drivers and the button expander */
+    I2CBus& GetPanelI2C() { return panel_i2c_; }
 
     TLC59116                    led_driver;
     daisy::DaisySeed            seed;
@@ -130,7 +144,7 @@ class FourSeasHW
     fourseas::CalibratedControl extra_knob;
     fourseas::CalibratedControl rotary_switch;
     AnalogControl24             adc_cvs[ADC_CV_LAST];
-    Button                      buttons[BUTTON_LAST];
+    Buttons                     buttons;
     // temp, should probably be private
     AdcMCP3564R      adc_;
     daisy::I2CHandle ext_i2c_handle_;
@@ -151,10 +165,15 @@ class FourSeasHW
     void InitADCCVs();
     void InitAudio();
     void InitExtI2C();
-
-    MCP23008           ext_gpio_;
-    dsy_gpio           adc_irq_pin_;
-    IWDG_HandleTypeDef hiwdg_;
+    void InitPanelI2C();
+
+    AudioConfig            audio_config_;
+    bool                   audio_running_ = false;
+    AdcMCP3564R::ScanFrame adc_frame_;
+    I2CBus                 panel_i2c_;
+    MCP23008               ext_gpio_;
+    dsy_gpio               adc_irq_pin_;
+    IWDG_HandleTypeDef     hiwdg_;
 };
 
 } // namespace fourseas
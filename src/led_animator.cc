@@ -0,0 +1,176 @@
+#include <algorithm>
+
+#include "daisy.h"
+#include "util/scopedirqblocker.h"
+
+#include "src/led_animator.h"
+
+namespace fourseas
+{
+namespace
+{
+// `fraction` of the way from a to b in perceived brightness, 0 to 256
+uint8_t Mix(uint8_t a, uint8_t b, uint32_t fraction)
+{
+    const int32_t from = kInverseGamma[a];
+    const int32_t to   = kInverseGamma[b];
+    return kGamma[from + ((to - from) * static_cast<int32_t>(fraction) >> 8)];
+}
+
+bool SameGroup(const LedAnimator::Group& a, const LedAnimator::Group& b)
+{
+    return a.red == b.red && a.green == b.green && a.blue == b.blue;
+}
+} // namespace
+
+void LedAnimator::Init(TLC59116* driver)
+{
+    daisy::ScopedIrqBlocker irq_blocker;
+
+    driver_ = driver;
+    count_  = 0;
+    active_ = false;
+}
+
+void LedAnimator::Play(const Group&     group,
+                       const Animation& animation,
+                       uint32_t         now_ms)
+{
+    Slot slot;
+    slot.group                   = group;
+    slot.animation               = animation;
+    slot.animation.num_keyframes = std::max<uint8_t>(
+        1, std::min<uint8_t>(animation.num_keyframes, kMaxKeyframes));
+    slot.from     = animation.start;
+    slot.keyframe = 0;
+    slot.pass     = 0;
+    slot.start_ms = now_ms;
+    slot.playing  = true;
+
+    // A pass that takes no time at all would never end
+    uint32_t pass_ms = 0;
+    for(size_t i = 0; i < slot.animation.num_keyframes; i++)
+    {
+        pass_ms += slot.animation.keyframes[i].fade_ms;
+    }
+    if(pass_ms == 0)
+    {
+        slot.animation.repeats = 1;
+    }
+
+    daisy::ScopedIrqBlocker irq_blocker;
+
+    // Slots are kept in the order they were started, oldest first, so
+    // rendering them in turn puts the newest on top
+    size_t kept = 0;
+    for(size_t i = 0; i < count_; i++)
+    {
+        if(slots_[i].playing && !SameGroup(slots_[i].group, group))
+        {
+            slots_[kept++] = slots_[i];
+        }
+    }
+    if(kept == kMaxAnimations)
+    {
+        std::copy(&slots_[1], &slots_[kMaxAnimations], &slots_[0]);
+        kept--;
+    }
+    slots_[kept] = slot;
+    count_       = kept + 1;
+    active_      = true;
+}
+
+void LedAnimator::Stop()
+{
+    daisy::ScopedIrqBlocker irq_blocker;
+
+    count_  = 0;
+    active_ = false;
+}
+
+void LedAnimator::Tick(uint32_t now_ms)
+{
+    if(!active_)
+    {
+        return;
+    }
+
+    bool playing = false;
+    for(size_t i = 0; i < count_; i++)
+    {
+        Slot& slot = slots_[i];
+        if(!slot.playing)
+        {
+            continue;
+        }
+        slot.playing = Advance(slot, now_ms);
+        Render(slot, now_ms);
+        playing |= slot.playing;
+    }
+
+    driver_->Transmit();
+
+    // Stay on until the last frame has gone out too
+    active_ = playing || driver_->Changed();
+}
+
+bool LedAnimator::Advance(Slot& slot, uint32_t now_ms)
+{
+    const Animation& animation = slot.animation;
+    for(;;)
+    {
+        const LedKeyframe& keyframe = animation.keyframes[slot.keyframe];
+        if(now_ms - slot.start_ms < keyframe.fade_ms)
+        {
+            return true;
+        }
+
+        slot.from = keyframe.color;
+        slot.keyframe++;
+        slot.start_ms += keyframe.fade_ms;
+        if(slot.keyframe < animation.num_keyframes)
+        {
+            continue;
+        }
+
+        slot.pass++;
+        if(animation.repeats != 0 && slot.pass >= animation.repeats)
+        {
+            // Left on the last keyframe's colour
+            return false;
+        }
+        slot.keyframe = 0;
+        slot.from     = animation.start;
+    }
+}
+
+void LedAnimator::Render(const Slot& slot, uint32_t now_ms)
+{
+    LedColor color = slot.from;
+    if(slot.playing)
+    {
+        const LedKeyframe& keyframe
+            = slot.animation.keyframes[slot.keyframe];
+        const uint32_t fraction
+            = ((now_ms - slot.start_ms) << 8) / keyframe.fade_ms;
+
+        color.r = Mix(slot.from.r, keyframe.color.r, fraction);
+        color.g = Mix(slot.from.g, keyframe.color.g, fraction);
+        color.b = Mix(slot.from.b, keyframe.color.b, fraction);
+    }
+
+    SetChannels(slot.group.red, color.r);
+    SetChannels(slot.group.green, color.g);
+    SetChannels(slot.group.blue, color.b);
+}
+
+void LedAnimator::SetChannels(uint64_t mask, uint8_t level)
+{
+    while(mask != 0)
+    {
+        driver_->Set(__builtin_ctzll(mask), level);
+        mask &= mask - 1;
+    }
+}
+
+} // namespace fourseas
@@ -0,0 +1,156 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <stdint.h>
+
+#include "src/drivers/TLC59116.h"
+
+namespace fourseas
+{
+// x^(1/5) on [0, 1] by Newton's method, for building the tables below
+constexpr float FifthRoot(float x)
+{
+    if(x <= 0.0f)
+    {
+        return 0.0f;
+    }
+    float y = 1.0f;
+    for(int i = 0; i < 32; i++)
+    {
+        y = (4.0f * y + x / (y * y * y * y)) / 5.0f;
+    }
+    return y;
+}
+
+// Perceived brightness to PWM level, gamma 2.2
+constexpr std::array<uint8_t, 256> MakeGammaTable()
+{
+    std::array<uint8_t, 256> table{};
+    for(size_t i = 0; i < table.size(); i++)
+    {
+        const float x = static_cast<float>(i) / 255.0f;
+        table[i]      = static_cast<uint8_t>(x * x * FifthRoot(x) * 255.0f
+                                        + 0.5f);
+    }
+    return table;
+}
+
+// PWM level to the lowest brightness that reaches it
+constexpr std::array<uint8_t, 256>
+MakeInverseGammaTable(const std::array<uint8_t, 256>& gamma)
+{
+    std::array<uint8_t, 256> table{};
+    size_t                   brightness = 0;
+    for(size_t level = 0; level < table.size(); level++)
+    {
+        while(brightness < 255 && gamma[brightness] < level)
+        {
+            brightness++;
+        }
+        table[level] = static_cast<uint8_t>(brightness);
+    }
+    return table;
+}
+
+constexpr std::array<uint8_t, 256> kGamma = MakeGammaTable();
+constexpr std::array<uint8_t, 256> kInverseGamma
+    = MakeInverseGammaTable(kGamma);
+
+struct LedColor
+{
+    uint8_t r, g, b;
+};
+
+/** Fade to `color` over `fade_ms`; 0 jumps straight there */
+struct LedKeyframe
+{
+    LedColor color;
+    uint16_t fade_ms;
+};
+
+/**
+    Plays keyframed crossfades on groups of RGB LEDs, without blocking.
+
+    An animation is plain data: a start colour and a few keyframes to fade
+    through, optionally repeated. Play() hands one over and returns at once;
+    Tick(), called from a timer interrupt, works out every running
+    animation for the current time and sends the result to the LED driver.
+
+    Fades run in perceived brightness rather than PWM level, through the
+    gamma tables above, so they look even at the dark end too. Keyframe
+    colours are PWM levels and land exactly as given.
+
+    While anything is playing the animator owns the LED driver; check
+    Active() before writing to it from elsewhere. Animations hold their
+    last colour when done.
+*/
+class LedAnimator
+{
+  public:
+    static constexpr size_t kMaxKeyframes = 4;
+
+    // A fade on every RGB LED, and more
+    static constexpr size_t kMaxAnimations = 16;
+
+    struct Animation
+    {
+        LedColor    start;
+        LedKeyframe keyframes[kMaxKeyframes];
+        uint8_t     num_keyframes;
+        uint8_t     repeats; // times through the keyframes, 0 for forever
+    };
+
+    /** LEDs an animation drives: bit n of each mask is driver channel n */
+    struct Group
+    {
+        uint64_t red;
+        uint64_t green;
+        uint64_t blue;
+    };
+
+    LedAnimator() {}
+    ~LedAnimator() {}
+
+    void Init(TLC59116* driver);
+
+    /**
+    Starts `animation` on `group` from `now_ms`, replacing whatever was
+    playing on that same group. Where groups overlap, the one started last
+    shows. When all slots are busy the oldest animation is dropped.
+    */
+    void Play(const Group& group, const Animation& animation, uint32_t now_ms);
+
+    /** Stops everything, leaving the LEDs as they are */
+    void Stop();
+
+    inline bool Active() const { return active_; }
+
+    /** Advances and renders every running animation; from a timer interrupt */
+    void Tick(uint32_t now_ms);
+
+  private:
+    struct Slot
+    {
+        Group     group;
+        Animation animation;
+        LedColor  from;      // colour the current keyframe fades from
+        uint8_t   keyframe;  // the one fading in
+        uint8_t   pass;      // times through the keyframes so far
+        uint32_t  start_ms;  // when the current keyframe started
+        bool      playing;
+    };
+
+    // Moves `slot` on to the keyframe `now_ms` falls in; false once done
+    bool Advance(Slot& slot, uint32_t now_ms);
+
+    void Render(const Slot& slot, uint32_t now_ms);
+    void SetChannels(uint64_t mask, uint8_t level);
+
+    TLC59116*     driver_;
+    Slot          slots_[kMaxAnimations];
+    size_t        count_;
+    volatile bool active_;
+};
+
+} // namespace fourseas
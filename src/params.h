@@ -3,47 +3,120 @@
 #include "stmlib/dsp/parameter_interpolator.h"
 #include "daisysp.h"
 
+#include "src/constants.h"
+
 namespace fourseas
 {
-class Params
+// Everything an oscillator reads at audio rate, ramped once per sample
+struct ParamValues
 {
-  public:
-    struct Values
-    {
-        float frequency;
-        float x;
-        float y;
-        float z;
-        float osc_mod_amount;
+    float frequency;
+    float x;
+    float y;
+    float z;
+    float osc_mod_amount;
+};
+
+// Compile-time list of the ParamValues fields an oscillator flavour consumes,
+// keyed on the same flag as WavetableOscillator's uses_modulation.
+template <bool uses_modulation>
+struct ParamSchema;
+
+// Derived outputs: osc_mod_amount is never read, so it is never ramped
+template <>
+struct ParamSchema<false>
+{
+    static constexpr float ParamValues::*kLanes[] = {
+        &ParamValues::frequency,
+        &ParamValues::x,
+        &ParamValues::y,
+        &ParamValues::z,
     };
+    static constexpr size_t kNumLanes = sizeof(kLanes) / sizeof(kLanes[0]);
+};
+
+template <>
+struct ParamSchema<true>
+{
+    static constexpr float ParamValues::*kLanes[] = {
+        &ParamValues::frequency,
+        &ParamValues::x,
+        &ParamValues::y,
+        &ParamValues::z,
+        &ParamValues::osc_mod_amount,
+    };
+    static constexpr size_t kNumLanes = sizeof(kLanes) / sizeof(kLanes[0]);
+};
 
+/**
+    Bank of interpolators that ramps only the lanes in Schema, writing
+    straight into a ParamValues owned by the caller (the oscillator).
+*/
+template <typename Schema>
+class Params
+{
+  public:
     Params() {}
     ~Params() {}
 
-    void   Init(size_t size);
-    void   Update(Params::Values vals);
-    Values Fetch();
+    void Init(ParamValues* state)
+    {
+        state_  = state;
+        *state_ = {};
+    }
 
-  private:
-    stmlib::ParameterInterpolator frequency_interpolator_;
-    stmlib::ParameterInterpolator x_interpolator_;
-    stmlib::ParameterInterpolator y_interpolator_;
-    stmlib::ParameterInterpolator z_interpolator_;
-    stmlib::ParameterInterpolator osc_mod_interpolator_;
+    // Starts a ramp from the current state to target, `size` samples long
+    void Update(const ParamValues& target, size_t size)
+    {
+        for(size_t i = 0; i < Schema::kNumLanes; i++)
+        {
+            float ParamValues::*lane = Schema::kLanes[i];
+            lanes_[i].Init(&(state_->*lane), target.*lane, size);
+        }
+    }
 
-    Values values_;
+    // Advances every lane by one sample. Should be called once per sample.
+    inline void Next()
+    {
+        for(size_t i = 0; i < Schema::kNumLanes; i++)
+        {
+            state_->*Schema::kLanes[i] = lanes_[i].Next();
+        }
+    }
 
-    size_t size_;
+  private:
+    ParamValues*                  state_;
+    stmlib::ParameterInterpolator lanes_[Schema::kNumLanes];
 };
 
 struct OscillatorParams
 {
-    const Params::Values& values;
-    bool                  interpolate;
-    uint8_t               mod_state  = 0;
-    float                 mod_input  = 0.0f;
-    uint8_t               sync_state = 0;
-    bool                  sync_input = false;
+    bool         interpolate;
+    uint8_t      mod_state  = 0;
+    const float* mod_input  = nullptr; // one block of audio, full oscs only
+    uint8_t      sync_state = 0;
+    const float* sync_input = nullptr; // one block of audio, full oscs only
+};
+
+// Most voices an output can stack in unison / chord mode
+static constexpr size_t kMaxVoices = 8;
+
+// Voices stacked on every output, as ratios of that output's frequency.
+// ratio[0] is always 1: the first voice is the output itself.
+struct VoiceSpread
+{
+    size_t count = 1;
+    float  ratio[kMaxVoices];
+};
+
+// Per-sample CV modulation for one block, built once and shared by all
+// four oscillators. Positions are offsets in wave units, FM is a ratio.
+struct CvRamps
+{
+    float fm_ratio[kMaxAudioBlockSize];
+    float x[kMaxAudioBlockSize];
+    float y[kMaxAudioBlockSize];
+    float z[kMaxAudioBlockSize];
 };
 
 // Utility function for applying dead zone to parameter values
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "stmlib/dsp/dsp.h"
+
+namespace fourseas
+{
+/**
+    Phase interpolation policies for WavetableOscillator.
+
+    Each reads one wave around `index + fractional` through `sample(i)`,
+    which is expected to wrap `i` into the table. kTaps is the number of
+    samples read, so the cost of a policy is roughly kTaps times that of a
+    single tap.
+*/
+
+// 2 taps. Cheapest; dull and noisy on short or transposed-down tables.
+struct LinearPhase
+{
+    static constexpr int32_t kTaps = 2;
+
+    static void Init() {}
+
+    template <typename Sample>
+    static inline float
+    Read(const Sample& sample, int32_t index, float fractional)
+    {
+        const float a = sample(index);
+        const float b = sample(index + 1);
+        return a + (b - a) * fractional;
+    }
+};
+
+// 4-point, 3rd-order Hermite
+struct HermitePhase
+{
+    static constexpr int32_t kTaps = 4;
+
+    static void Init() {}
+
+    template <typename Sample>
+    static inline float
+    Read(const Sample& sample, int32_t index, float fractional)
+    {
+        const float xm1 = sample(index - 1);
+        const float x0  = sample(index);
+        const float x1  = sample(index + 1);
+        const float x2  = sample(index + 2);
+
+        const float c     = (x1 - xm1) * 0.5f;
+        const float v     = x0 - x1;
+        const float w     = c + v;
+        const float a     = w + v + (x2 - x0) * 0.5f;
+        const float b_neg = w + a;
+        const float t     = fractional;
+        return (((a * t) - b_neg) * t + c) * t + x0;
+    }
+};
+
+// 8-tap Blackman-windowed sinc, from a 64-phase kernel table
+struct SincPhase
+{
+    static constexpr int32_t kTaps   = 8;
+    static constexpr size_t  kPhases = 64;
+
+    // Fills the kernel table. Not real-time safe; call before audio starts.
+    static void Init()
+    {
+        static constexpr float kHalfWidth = kTaps / 2;
+        for(size_t phase = 0; phase <= kPhases; phase++)
+        {
+            const float t   = static_cast<float>(phase) / kPhases;
+            float       sum = 0.0f;
+            for(int32_t k = 0; k < kTaps; k++)
+            {
+                const float x = static_cast<float>(k - (kTaps / 2 - 1)) - t;
+
+                float sinc = 1.0f;
+                if(fabsf(x) > 1e-6f)
+                {
+                    sinc = sinf(M_PI * x) / (M_PI * x);
+                }
+                const float w      = M_PI * x / kHalfWidth;
+                const float window = 0.42f + 0.5f * cosf(w)
+                                     + 0.08f * cosf(2.0f * w);
+
+                kernel_[phase][k] = sinc * window;
+                sum += kernel_[phase][k];
+            }
+
+            // Unity gain at DC for every phase
+            for(int32_t k = 0; k < kTaps; k++)
+            {
+                kernel_[phase][k] /= sum;
+            }
+        }
+    }
+
+    template <typename Sample>
+    static inline float
+    Read(const Sample& sample, int32_t index, float fractional)
+    {
+        float position = fractional * kPhases;
+        MAKE_INTEGRAL_FRACTIONAL(position);
+
+        const float* a = kernel_[position_integral];
+        const float* b = kernel_[position_integral + 1];
+
+        const int32_t first = index - (kTaps / 2 - 1);
+
+        float sum = 0.0f;
+        for(int32_t k = 0; k < kTaps; k++)
+        {
+            const float tap = a[k] + (b[k] - a[k]) * position_fractional;
+            sum += sample(first + k) * tap;
+        }
+        return sum;
+    }
+
+    inline static float kernel_[kPhases + 1][kTaps];
+};
+
+} // namespace fourseas
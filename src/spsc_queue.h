@@ -0,0 +1,68 @@
+#pragma once
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+
+namespace fourseas
+{
+/**
+    Single-producer, single-consumer queue.
+    Safe to share between one interrupt and one other context without locks,
+    as long as each side only calls its own half of the interface.
+    \tparam capacity must be a power of two
+*/
+template <typename T, size_t capacity>
+class SpscQueue
+{
+    static_assert((capacity & (capacity - 1)) == 0,
+                  "SpscQueue capacity must be a power of two");
+
+  public:
+    SpscQueue() {}
+    ~SpscQueue() {}
+
+    /** Producer side. Returns false (and drops the item) when full. */
+    bool Push(const T& item)
+    {
+        uint32_t head = head_.load(std::memory_order_relaxed);
+        if(head - tail_.load(std::memory_order_acquire) >= capacity)
+        {
+            return false;
+        }
+        items_[head & kMask] = item;
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    /** Consumer side. Returns false when there is nothing to read. */
+    bool Pop(T& item)
+    {
+        uint32_t tail = tail_.load(std::memory_order_relaxed);
+        if(tail == head_.load(std::memory_order_acquire))
+        {
+            return false;
+        }
+        item = items_[tail & kMask];
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /** Number of items waiting, as seen from either side */
+    size_t Size() const
+    {
+        return head_.load(std::memory_order_acquire)
+               - tail_.load(std::memory_order_acquire);
+    }
+
+    bool Empty() const { return Size() == 0; }
+
+  private:
+    static constexpr uint32_t kMask = capacity - 1;
+
+    T                     items_[capacity];
+    std::atomic<uint32_t> head_{0};
+    std::atomic<uint32_t> tail_{0};
+};
+
+} // namespace fourseas
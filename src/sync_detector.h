@@ -0,0 +1,86 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "src/constants.h"
+
+namespace fourseas
+{
+/** Rising edges found in one block of a sync input */
+struct SyncEdges
+{
+    // An input has to fall back below the low threshold between two edges,
+    // so a block holds at most one edge every other sample.
+    static constexpr size_t kMaxEdges = kMaxAudioBlockSize / 2 + 1;
+
+    size_t count;
+
+    // First sample rendered after the edge
+    uint8_t index[kMaxEdges];
+
+    // How far before `index` the edge crossed, in samples (0 to 1)
+    float fraction[kMaxEdges];
+};
+
+/**
+    Schmitt-trigger edge detector for the sync inputs.
+
+    Scans a whole block up front and reports only the rising edges, so the
+    renderer can run without a per-sample comparison and act on the edges
+    alone. The hysteresis keeps noise on a slow or dirty sync cable from
+    retriggering around the threshold.
+*/
+class SyncDetector
+{
+  public:
+    SyncDetector() {}
+    ~SyncDetector() {}
+
+    void Init()
+    {
+        high_     = false;
+        previous_ = 0.0f;
+    }
+
+    void Process(const float* in, size_t size, SyncEdges* edges)
+    {
+        size_t count    = 0;
+        bool   high     = high_;
+        float  previous = previous_;
+
+        for(size_t i = 0; i < size; i++)
+        {
+            const float sample = in[i];
+            if(!high && sample > kHighThreshold)
+            {
+                // Linear estimate of where the upper threshold was crossed
+                float fraction
+                    = (sample - kHighThreshold) / (sample - previous);
+                edges->index[count]    = static_cast<uint8_t>(i);
+                edges->fraction[count] = fraction < 1.0f ? fraction : 1.0f;
+                count++;
+                high = true;
+            }
+            else if(high && sample < kLowThreshold)
+            {
+                high = false;
+            }
+            previous = sample;
+        }
+
+        edges->count = count;
+        high_        = high;
+        previous_    = previous;
+    }
+
+  private:
+    // Centred on the old fixed 0.05 threshold, in audio input units
+    static constexpr float kHighThreshold = 0.07f;
+    static constexpr float kLowThreshold  = 0.03f;
+
+    bool  high_;
+    float previous_;
+};
+
+} // namespace fourseas
@@ -1,4 +1,5 @@
 #include "stmlib/stmlib.h"
+#include "stmlib/dsp/units.h"
 #include "daisysp.h"
 
 #include "src/constants.h"
@@ -13,6 +14,14 @@ constexpr uint32_t intervalTicks = 1000 * 3; // ~3 seconds, experiment with this
 
 static const float spread_coeffs[4] = {0.0f, 2.3333f, 4.6666f, 6.9999f};
 
+// Full-scale FM CV in semitones
+static constexpr float kFmCvRange = 60.0f;
+
+// Span of stmlib::SemitonesToRatio()'s tables. An overranged FM CV can
+// read past +/-1 full scale, so it is held to this before the lookup.
+static constexpr float kFmSemitonesMin = -128.0f;
+static constexpr float kFmSemitonesMax = 127.0f;
+
 static constexpr uint8_t LED_COLOR_ONE_R = 0;
 static constexpr uint8_t LED_COLOR_ONE_G = 145;
 static constexpr uint8_t LED_COLOR_ONE_B = 255;
@@ -31,6 +40,8 @@ Ui::Init(FourSeasHW*                             hw,
     settingsStorage_ = settingsStorage;
     appStateStorage_ = appStateStorage;
 
+    led_animator_.Init(&hw_->led_driver);
+
     Settings settings;
     settingsStorage_->Init(settings.Default());
 
@@ -42,11 +53,28 @@ Ui::Init(FourSeasHW*                             hw,
     // Get local reference to settings struct
     state_ = &appStateStorage_->GetSettings();
 
-    for(size_t i = 0; i < 4; i++)
+    // State saved before voices existed reads garbage there
+    if(state_->voices < 1 || state_->voices > kMaxVoices)
     {
-        synth_params_[i].Init(hw_->AudioBlockSize());
+        state_->voices = 1;
     }
 
+    InitControls();
+
+    // FM and position CVs are rendered at audio rate from the scan stream
+    cv_stream_.Init(&hw_->adc_,
+                    hw_->adc_cvs,
+                    (1 << hw_->ADC_CV_4) | (1 << hw_->ADC_CV_2)
+                        | (1 << hw_->ADC_CV_1) | (1 << hw_->ADC_CV_0));
+
+    // FM and X move fastest; the rest come in on the full scans
+    AdcScheduler::Config adc_config;
+    adc_config.fast_channels = (1 << hw_->ADC_CV_4) | (1 << hw_->ADC_CV_2);
+    adc_scheduler_.Init(&hw_->adc_, adc_config);
+}
+
+__attribute__((optimize("Os"))) void Ui::InitControls()
+{
     // Apply offsets from saved config
     for(size_t i = 0; i < hw_->ADC_CV_LAST; i++)
     {
@@ -140,7 +168,7 @@ Ui::Init(FourSeasHW*                             hw,
         hw_->adc_cvs[hw_->ADC_CV_5], 0.0f, 1.0f, fourseas::Parameter24::LINEAR);
     cvs[CV_FM].Init(hw_->adc_cvs[hw_->ADC_CV_4],
                     0.0f,
-                    60.0f,
+                    kFmCvRange,
                     fourseas::Parameter24::LINEAR);
 
     bank_cv.Init(
@@ -151,6 +179,9 @@ __attribute__((optimize("Os"))) void Ui::Calibrate()
 {
     SetLEDsOff();
 
+    // Slow, low-noise scans for the offsets and the V/Oct references
+    adc_scheduler_.BeginCalibration();
+
     // 1. Launch calibration by pressing both osc mod buttons
     // Little light show to indicate cal start
     for(size_t i = 0; i < 3; i++)
@@ -172,6 +203,15 @@ __attribute__((optimize("Os"))) void Ui::Calibrate()
     {
         hw_->RefreshWatchdog();
 
+        // adc_cvs read the latched scan, which the audio callback moves on
+        // while it runs. If audio never started (no wavetables) nothing
+        // would, so latch here instead; never both, as ReadScan() updates
+        // the frame and the driver's scan counts unguarded.
+        if(!hw_->AudioRunning())
+        {
+            hw_->LatchExtADC();
+        }
+
         hw_->led_driver.Set(LED_R_OSC_SYNC_TYPE_2, 255);
         hw_->led_driver.Set(LED_G_OSC_SYNC_TYPE_2, 255);
         hw_->led_driver.Set(LED_G_OSC_SYNC_TYPE_2, 255);
@@ -215,7 +255,7 @@ __attribute__((optimize("Os"))) void Ui::Calibrate()
                        + calData_->bank_offset)
                       / 2.0f;
 
-                if(isButtonReleased(SW_OSC_SYNC_TYPE_2))
+                if(TakeRelease(SW_OSC_SYNC_TYPE_2))
                 {
                     SetLEDsOff();
                     cal_state = Settings::CALIBRATION_HIGH;
@@ -235,7 +275,7 @@ __attribute__((optimize("Os"))) void Ui::Calibrate()
             {
                 SetLEDsGreen();
 
-                if(isButtonReleased(SW_OSC_SYNC_TYPE_2))
+                if(TakeRelease(SW_OSC_SYNC_TYPE_2))
                 {
                     // Coarse tuning knob
                     calData_->knob_scales[hw_->KNOB_14]
@@ -264,7 +304,7 @@ __attribute__((optimize("Os"))) void Ui::Calibrate()
 
                 v1 = hw_->cv[hw_->ONBOARD_CV_0].Process();
 
-                if(isButtonReleased(SW_OSC_SYNC_TYPE_2))
+                if(TakeRelease(SW_OSC_SYNC_TYPE_2))
                 {
                     SetLEDsOff();
                     cal_state = Settings::CALIBRATION_C3;
@@ -281,7 +321,7 @@ __attribute__((optimize("Os"))) void Ui::Calibrate()
 
                 v3 = hw_->cv[hw_->ONBOARD_CV_0].Process();
 
-                if(isButtonReleased(SW_OSC_SYNC_TYPE_2))
+                if(TakeRelease(SW_OSC_SYNC_TYPE_2))
                 {
                     SetLEDsOff();
                     cal_state = Settings::CALIBRATION_SPREAD_SWITCH;
@@ -301,7 +341,7 @@ __attribute__((optimize("Os"))) void Ui::Calibrate()
                     float spr = params[SPREAD_SWITCH].Process();
                     calData_->rotary_switch_thresholds[i] = spr;
 
-                    if(isButtonReleased(SW_OSC_SYNC_TYPE_2))
+                    if(TakeRelease(SW_OSC_SYNC_TYPE_2))
                     {
                         i++;
                         hw_->led_driver.Set(bank_leds_[i][0], 255);
@@ -335,34 +375,87 @@ __attribute__((optimize("Os"))) void Ui::Calibrate()
     vcal_.GetData(calData_->pitch_scale, calData_->pitch_offset);
 
     settingsStorage_->Save();
+
+    adc_scheduler_.EndCalibration();
 }
 
 // Returns true if calibration routine was executed. Seems like there should be a more elegant way
 bool Ui::Process()
 {
-    if(isButtonDown(SW_OSC_MODE_1) && isButtonDown(SW_OSC_MODE_2))
+    if(hw_->buttons.TimeHeldMs(SW_OSC_MODE_1) > 5000
+       && hw_->buttons.TimeHeldMs(SW_OSC_MODE_2) > 5000)
+    {
+        Calibrate();
+        return true;
+    }
+
+    adc_scheduler_.Process(hw_->GetNow());
+
+    ButtonEvent event;
+    while(PopTap(event))
+    {
+        HandleRelease(event);
+    }
+
+    float switch_mode = params[SPREAD_SWITCH].Process();
+    SetSpreadType(switch_mode);
+
+    float b_tot = (params[POT_BANK].Process() + bank_cv.Process())
+                  * static_cast<float>(max_banks_);
+    b_tot = daisysp::fclamp(b_tot, 0.0f, static_cast<float>(max_banks_ - 1));
+    bank_num_ = static_cast<uint8_t>(b_tot);
+
+    UpdateLEDs();
+
+    uint32_t currentTime = hw_->GetNow();
+
+    if((currentTime - lastExecutionTime) >= intervalTicks)
+    {
+        appStateStorage_->Save();
+        lastExecutionTime = currentTime;
+    }
+
+    return false;
+}
+
+
+// Buttons act when let go, so the tuning lock can double as a shift
+void Ui::HandleRelease(const ButtonEvent& event)
+{
+    const bool lock_held = (event.down >> SW_TUNING_LOCK) & 1;
+
+    // voices: hold tuning lock and tap interpolate, 1-2-3-4-6-8
+    if(lock_held && event.button == SW_WAVE_INTERPOLATE_TOGGLE)
     {
-        if(hw_->buttons[SW_OSC_MODE_1].TimeHeldMs() > 5000
-           && hw_->buttons[SW_OSC_MODE_1].TimeHeldMs() > 5000)
+        uint8_t voices = state_->voices;
+        if(voices >= kMaxVoices)
         {
-            Calibrate();
-            return true;
+            voices = 1;
+        }
+        else
+        {
+            voices += voices < 4 ? 1 : 2;
         }
+        state_->voices   = voices;
+        lock_shift_used_ = true;
     }
-
     // interpolate_waves
-    if(isButtonReleased(SW_WAVE_INTERPOLATE_TOGGLE))
+    else if(event.button == SW_WAVE_INTERPOLATE_TOGGLE)
     {
         state_->interpolate_waves = !state_->interpolate_waves;
     }
 
-    // lock_tuning
-    if(isButtonReleased(SW_TUNING_LOCK))
+    // lock_tuning, unless the press was used as a shift button
+    if(event.button == SW_TUNING_LOCK)
     {
-        lock_tuning_ = !lock_tuning_;
+        if(!lock_shift_used_)
+        {
+            lock_tuning_ = !lock_tuning_;
+        }
+        lock_shift_used_ = false;
     }
 
-    if(isButtonReleased(SW_OSC_MODE_1))
+    if(event.button == SW_OSC_MODE_1)
     {
         switch(state_->mod_state_1)
         {
@@ -379,6 +472,18 @@ bool Ui::Process()
             }
 
             case AppState::MOD_STATES::XOR:
+            {
+                state_->mod_state_1 = AppState::MOD_STATES::EXP_FM;
+                break;
+            }
+
+            case AppState::MOD_STATES::EXP_FM:
+            {
+                state_->mod_state_1 = AppState::MOD_STATES::LINEAR_FM;
+                break;
+            }
+
+            case AppState::MOD_STATES::LINEAR_FM:
             {
                 state_->mod_state_1 = AppState::MOD_STATES::PHASE_MOD;
                 break;
@@ -388,7 +493,7 @@ bool Ui::Process()
         }
     }
 
-    if(isButtonReleased(SW_OSC_MODE_2))
+    if(event.button == SW_OSC_MODE_2)
     {
         switch(state_->mod_state_2)
         {
@@ -405,6 +510,18 @@ bool Ui::Process()
             }
 
             case AppState::MOD_STATES::XOR:
+            {
+                state_->mod_state_2 = AppState::MOD_STATES::EXP_FM;
+                break;
+            }
+
+            case AppState::MOD_STATES::EXP_FM:
+            {
+                state_->mod_state_2 = AppState::MOD_STATES::LINEAR_FM;
+                break;
+            }
+
+            case AppState::MOD_STATES::LINEAR_FM:
             {
                 state_->mod_state_2 = AppState::MOD_STATES::PHASE_MOD;
                 break;
@@ -416,17 +533,28 @@ bool Ui::Process()
 
 
     // LFO modes
-    if(isButtonReleased(SW_LFO_TOGGLE_1))
+    // capture: hold tuning lock and tap LFO 1, or LFO 2 to also save it
+    if(lock_held && event.button == SW_LFO_TOGGLE_1)
+    {
+        capture_request_ = CAPTURE;
+        lock_shift_used_ = true;
+    }
+    else if(event.button == SW_LFO_TOGGLE_1)
     {
         state_->lfo_state_1 = !state_->lfo_state_1;
     }
 
-    if(isButtonReleased(SW_LFO_TOGGLE_2))
+    if(lock_held && event.button == SW_LFO_TOGGLE_2)
+    {
+        capture_request_ = CAPTURE_AND_SAVE;
+        lock_shift_used_ = true;
+    }
+    else if(event.button == SW_LFO_TOGGLE_2)
     {
         state_->lfo_state_2 = !state_->lfo_state_2;
     }
 
-    if(isButtonReleased(SW_OSC_SYNC_TYPE_1))
+    if(event.button == SW_OSC_SYNC_TYPE_1)
     {
         switch(state_->sync_mode_1)
         {
@@ -452,7 +580,7 @@ bool Ui::Process()
         }
     }
 
-    if(isButtonReleased(SW_OSC_SYNC_TYPE_2))
+    if(event.button == SW_OSC_SYNC_TYPE_2)
     {
         switch(state_->sync_mode_2)
         {
@@ -477,29 +605,8 @@ bool Ui::Process()
             default: break;
         }
     }
-
-    float switch_mode = params[SPREAD_SWITCH].Process();
-    SetSpreadType(switch_mode);
-
-    float b_tot = (params[POT_BANK].Process() + bank_cv.Process())
-                  * static_cast<float>(max_banks_);
-    b_tot = daisysp::fclamp(b_tot, 0.0f, static_cast<float>(max_banks_ - 1));
-    bank_num_ = static_cast<uint8_t>(b_tot);
-
-    UpdateLEDs();
-
-    uint32_t currentTime = hw_->GetNow();
-
-    if((currentTime - lastExecutionTime) >= intervalTicks)
-    {
-        appStateStorage_->Save();
-        lastExecutionTime = currentTime;
-    }
-
-    return false;
 }
 
-
 void Ui::SetSpreadType(float switch_mode)
 {
     // Loop through thresholds
@@ -524,37 +631,30 @@ void Ui::SetSpreadType(float switch_mode)
 
 void Ui::UpdateParams()
 {
-    Params::Values vals;
+    ParamValues vals;
 
     float freq_val = 0.0f;
 
+    // Every CV read in this tick comes from the same scan
+    hw_->LatchExtADC();
+    BuildCvRamps(hw_->AudioBlockSize());
+
     // Update tuning pots if not locked
     if(!lock_tuning_)
     {
         freq_pots_ = params[POT_TUNING_COARSE].Process()
                      + params[POT_TUNING_FINE].Process();
     }
+    // FM CV is applied per sample, see BuildCvRamps()
     freq_val = freq_pots_
-               + vcal_.ProcessInput(hw_->cv[hw_->ONBOARD_CV_0].Process())
-               + (cvs[CV_FM].Process() * params[POT_FM_ATT].Process());
+               + vcal_.ProcessInput(hw_->cv[hw_->ONBOARD_CV_0].Process());
 
     freq_val = daisysp::mtof(freq_val);
 
-    // x, y, z positions
-    float x_val
-        = params[POT_X].Process()
-          + (cvs[CV_X_POSITION].Process() * params[POT_X_ATT].Process());
-    x_val = daisysp::fclamp(x_val, 0.0f, 6.9999f);
-
-    float y_val
-        = params[POT_Y].Process()
-          + (cvs[CV_Y_POSITION].Process() * params[POT_Y_ATT].Process());
-    y_val = daisysp::fclamp(y_val, 0.0f, 6.9999f);
-
-    float z_val
-        = params[POT_Z].Process()
-          + (cvs[CV_Z_POSITION].Process() * params[POT_Z_ATT].Process());
-    z_val = daisysp::fclamp(z_val, 0.0f, 6.9999f);
+    // x, y, z positions (CV is applied per sample, see BuildCvRamps())
+    float x_val = daisysp::fclamp(params[POT_X].Process(), 0.0f, 6.9999f);
+    float y_val = daisysp::fclamp(params[POT_Y].Process(), 0.0f, 6.9999f);
+    float z_val = daisysp::fclamp(params[POT_Z].Process(), 0.0f, 6.9999f);
 
     // x, y, z spread amounts
     float x_spread_amt
@@ -575,6 +675,8 @@ void Ui::UpdateParams()
                           * params[POT_FREQ_SPREAD_ATT].Process());
     spread_val = daisysp::fclamp(spread_val, -1.0f, 1.0f);
 
+    UpdateVoices(spread_val);
+
     float osc_mod_depth_pot_1 = params[POT_OSC_MOD_DEPTH_1].Process();
     float osc_mod_depth_pot_2 = params[POT_OSC_MOD_DEPTH_2].Process();
 
@@ -629,8 +731,9 @@ void Ui::UpdateParams()
             }
         }
 
-        vals.frequency = daisysp::fclamp(
-            f0 / hw_->AudioSampleRate(), kMinFrequency, kMaxFrequency);
+        const float sample_rate = hw_->AudioSampleRate();
+        vals.frequency          = daisysp::fclamp(
+            f0 / sample_rate, kMinFrequency, kMaxFrequencyHz / sample_rate);
 
         // x_spread_amt = pot + cv
         float x_spread_val = x_val + (x_spread_amt * spread_coeffs[i]);
@@ -645,19 +748,53 @@ void Ui::UpdateParams()
         z_spread_val       = daisysp::fclamp(z_spread_val, 0.0f, 6.9999f);
         vals.z             = z_spread_val;
 
-        synth_params_[i].Update(vals);
+        targets_[i] = vals;
     }
 }
 
-Params::Values Ui::GetParams(size_t idx)
+void Ui::BuildCvRamps(size_t size)
 {
-    return synth_params_[idx].Fetch();
+    size = std::min(size, kMaxAudioBlockSize);
+
+    cv_stream_.Process(daisy::System::GetUs(), hw_->AudioSampleRate(), size);
+
+    // Keep the block-rate values current for the LEDs
+    cvs[CV_FM].Process();
+    cvs[CV_X_POSITION].Process();
+    cvs[CV_Y_POSITION].Process();
+    cvs[CV_Z_POSITION].Process();
+
+    const float fm_amount = kFmCvRange * params[POT_FM_ATT].Process();
+    const float x_amount  = 6.9999f * params[POT_X_ATT].Process();
+    const float y_amount  = 6.9999f * params[POT_Y_ATT].Process();
+    const float z_amount  = 6.9999f * params[POT_Z_ATT].Process();
+
+    const float* fm = cv_stream_.Ramp(hw_->ADC_CV_4);
+    const float* x  = cv_stream_.Ramp(hw_->ADC_CV_2);
+    const float* y  = cv_stream_.Ramp(hw_->ADC_CV_1);
+    const float* z  = cv_stream_.Ramp(hw_->ADC_CV_0);
+
+    for(size_t i = 0; i < size; i++)
+    {
+        const float semitones = daisysp::fclamp(
+            fm[i] * fm_amount, kFmSemitonesMin, kFmSemitonesMax);
+        cv_ramps_.fm_ratio[i] = stmlib::SemitonesToRatio(semitones);
+        cv_ramps_.x[i]        = x[i] * x_amount;
+        cv_ramps_.y[i]        = y[i] * y_amount;
+        cv_ramps_.z[i]        = z[i] * z_amount;
+    }
 }
 
 
 void Ui::UpdateLEDs()
 
 {
+    // An animation is running from the timer and has the LEDs
+    if(led_animator_.Active())
+    {
+        return;
+    }
+
     // If waves failed to load, show breathing red
     if(!waves_loaded_)
     {
@@ -695,6 +832,20 @@ void Ui::UpdateLEDs()
     constexpr uint8_t LED_COLOR_MID_B
         = crossfade(LED_COLOR_ONE_B, LED_COLOR_TWO_B, 0.5f);
 
+    // FM modes sit either side of XOR's midpoint
+    constexpr uint8_t LED_COLOR_FM_EXP_R
+        = crossfade(LED_COLOR_ONE_R, LED_COLOR_TWO_R, 0.25f);
+    constexpr uint8_t LED_COLOR_FM_EXP_G
+        = crossfade(LED_COLOR_ONE_G, LED_COLOR_TWO_G, 0.25f);
+    constexpr uint8_t LED_COLOR_FM_EXP_B
+        = crossfade(LED_COLOR_ONE_B, LED_COLOR_TWO_B, 0.25f);
+    constexpr uint8_t LED_COLOR_FM_LIN_R
+        = crossfade(LED_COLOR_ONE_R, LED_COLOR_TWO_R, 0.75f);
+    constexpr uint8_t LED_COLOR_FM_LIN_G
+        = crossfade(LED_COLOR_ONE_G, LED_COLOR_TWO_G, 0.75f);
+    constexpr uint8_t LED_COLOR_FM_LIN_B
+        = crossfade(LED_COLOR_ONE_B, LED_COLOR_TWO_B, 0.75f);
+
 
     hw_->led_driver.Set(LED_WAVE_INTERPOLATE_TOGGLE,
                         state_->interpolate_waves ? 127 : 0);
@@ -725,6 +876,18 @@ void Ui::UpdateLEDs()
             hw_->led_driver.Set(LED_B_OSC_MODE_1, LED_COLOR_MID_B);
             break;
 
+        case AppState::MOD_STATES::EXP_FM:
+            hw_->led_driver.Set(LED_R_OSC_MODE_1, LED_COLOR_FM_EXP_R);
+            hw_->led_driver.Set(LED_G_OSC_MODE_1, LED_COLOR_FM_EXP_G);
+            hw_->led_driver.Set(LED_B_OSC_MODE_1, LED_COLOR_FM_EXP_B);
+            break;
+
+        case AppState::MOD_STATES::LINEAR_FM:
+            hw_->led_driver.Set(LED_R_OSC_MODE_1, LED_COLOR_FM_LIN_R);
+            hw_->led_driver.Set(LED_G_OSC_MODE_1, LED_COLOR_FM_LIN_G);
+            hw_->led_driver.Set(LED_B_OSC_MODE_1, LED_COLOR_FM_LIN_B);
+            break;
+
         default: break;
     }
 
@@ -749,6 +912,18 @@ void Ui::UpdateLEDs()
             hw_->led_driver.Set(LED_B_OSC_MODE_2, LED_COLOR_MID_B);
             break;
 
+        case AppState::MOD_STATES::EXP_FM:
+            hw_->led_driver.Set(LED_R_OSC_MODE_2, LED_COLOR_FM_EXP_R);
+            hw_->led_driver.Set(LED_G_OSC_MODE_2, LED_COLOR_FM_EXP_G);
+            hw_->led_driver.Set(LED_B_OSC_MODE_2, LED_COLOR_FM_EXP_B);
+            break;
+
+        case AppState::MOD_STATES::LINEAR_FM:
+            hw_->led_driver.Set(LED_R_OSC_MODE_2, LED_COLOR_FM_LIN_R);
+            hw_->led_driver.Set(LED_G_OSC_MODE_2, LED_COLOR_FM_LIN_G);
+            hw_->led_driver.Set(LED_B_OSC_MODE_2, LED_COLOR_FM_LIN_B);
+            break;
+
         default: break;
     }
 
@@ -965,129 +1140,67 @@ void Ui::SetLEDsOn()
     SetLEDsByValue(255);
 }
 
-void Ui::StartupLEDSequence()
+LedAnimator::Group Ui::AllRgbLeds()
 {
-    constexpr uint32_t fade_duration   = 1500; // 1.5 seconds
-    constexpr uint32_t update_interval = 20;   // 50fps
-
-    uint32_t start_time  = hw_->GetNow();
-    uint32_t last_update = start_time;
-
-    while((hw_->GetNow() - start_time) < fade_duration)
-    {
-        uint32_t current_time = hw_->GetNow();
-        if(current_time - last_update >= update_interval)
-        {
-            last_update = current_time;
-
-            // Calculate fade progress (0.0 to 1.0)
-            float progress = (float)(current_time - start_time) / fade_duration;
-
-            // Crossfade from white (255,255,255) to blue (0,145,255)
-            uint8_t r = crossfade(255, LED_COLOR_ONE_R, progress);
-            uint8_t g = crossfade(255, LED_COLOR_ONE_G, progress);
-            uint8_t b = crossfade(255, LED_COLOR_ONE_B, progress);
-
-            // Set all RGB LEDs using the correct arrays
-            for(const auto& led : red_leds_)
-            {
-                hw_->led_driver.Set(led, r);
-            }
-            for(const auto& led : green_leds_)
-            {
-                hw_->led_driver.Set(led, g);
-            }
-            for(const auto& led : blue_leds_)
-            {
-                hw_->led_driver.Set(led, b);
-            }
+    return {ChannelMask(red_leds_),
+            ChannelMask(green_leds_),
+            ChannelMask(blue_leds_)};
+}
 
-            hw_->UpdateLEDs();
-        }
-        hw_->DelayMs(5);
-    }
+void Ui::StartupLEDSequence()
+{
+    // White to color one over 1.5 seconds
+    LedAnimator::Animation animation = {};
+    animation.start                  = {255, 255, 255};
+    animation.keyframes[0]
+        = {{LED_COLOR_ONE_R, LED_COLOR_ONE_G, LED_COLOR_ONE_B}, 1500};
+    animation.num_keyframes = 1;
+    animation.repeats       = 1;
+
+    led_animator_.Play(AllRgbLeds(), animation, hw_->GetNow());
 }
 
 void Ui::FadeBankLED(size_t bank_index)
 {
-    constexpr uint32_t fade_duration   = 150;
-    constexpr uint32_t update_interval = 10;
-
-    uint32_t start_time  = hw_->GetNow();
-    uint32_t last_update = start_time;
-
-
     if(bank_index >= sizeof(bank_leds_) / sizeof(bank_leds_[0]))
     {
         return; // Invalid bank index
     }
 
-    while((hw_->GetNow() - start_time) < fade_duration)
-    {
-        uint32_t current_time = hw_->GetNow();
-        if(current_time - last_update >= update_interval)
-        {
-            last_update = current_time;
-
-            // Calculate fade progress (0.0 to 1.0)
-            float progress = (float)(current_time - start_time) / fade_duration;
+    const LedAnimator::Group group = {uint64_t{1} << bank_leds_[bank_index][0],
+                                      uint64_t{1} << bank_leds_[bank_index][1],
+                                      uint64_t{1} << bank_leds_[bank_index][2]};
 
-            // Crossfade from color one to color two
-            uint8_t r = crossfade(LED_COLOR_ONE_R, LED_COLOR_TWO_R, progress);
-            uint8_t g = crossfade(LED_COLOR_ONE_G, LED_COLOR_TWO_G, progress);
-            uint8_t b = crossfade(LED_COLOR_ONE_B, LED_COLOR_TWO_B, progress);
+    // Color one to color two
+    LedAnimator::Animation animation = {};
+    animation.start = {LED_COLOR_ONE_R, LED_COLOR_ONE_G, LED_COLOR_ONE_B};
+    animation.keyframes[0]
+        = {{LED_COLOR_TWO_R, LED_COLOR_TWO_G, LED_COLOR_TWO_B}, 150};
+    animation.num_keyframes = 1;
+    animation.repeats       = 1;
 
-            // Set the specific bank's LEDs
-            hw_->led_driver.Set(bank_leds_[bank_index][0], r);
-            hw_->led_driver.Set(bank_leds_[bank_index][1], g);
-            hw_->led_driver.Set(bank_leds_[bank_index][2], b);
-
-            hw_->UpdateLEDs();
-        }
-        hw_->DelayMs(2);
-    }
+    led_animator_.Play(group, animation, hw_->GetNow());
 }
 
 void Ui::FadeToColor(uint8_t  target_r,
                      uint8_t  target_g,
                      uint8_t  target_b,
-                     uint32_t duration_ms)
+                     uint16_t duration_ms,
+                     uint8_t  repeats)
 {
-    constexpr uint32_t update_interval = 20; // 50fps
-
-    uint32_t start_time  = hw_->GetNow();
-    uint32_t last_update = start_time;
-
     // Fades from black in this case
-    uint8_t start_r = 0, start_g = 0, start_b = 0;
-
-    while((hw_->GetNow() - start_time) < duration_ms)
-    {
-        uint32_t current_time = hw_->GetNow();
-        if(current_time - last_update >= update_interval)
-        {
-            last_update = current_time;
-
-            // Calculate fade progress (0.0 to 1.0)
-            float progress = (float)(current_time - start_time) / duration_ms;
+    LedAnimator::Animation animation = {};
+    animation.start                  = {0, 0, 0};
+    animation.keyframes[0]  = {{target_r, target_g, target_b}, duration_ms};
+    animation.num_keyframes = 1;
+    animation.repeats       = repeats;
 
-            // Crossfade to target color
-            uint8_t r = crossfade(start_r, target_r, progress);
-            uint8_t g = crossfade(start_g, target_g, progress);
-            uint8_t b = crossfade(start_b, target_b, progress);
-
-            // Set all RGB LEDs using the existing arrays
-            for(const auto& led : red_leds_)
-                hw_->led_driver.Set(led, r);
-            for(const auto& led : green_leds_)
-                hw_->led_driver.Set(led, g);
-            for(const auto& led : blue_leds_)
-                hw_->led_driver.Set(led, b);
+    led_animator_.Play(AllRgbLeds(), animation, hw_->GetNow());
+}
 
-            hw_->UpdateLEDs();
-        }
-        hw_->DelayMs(5);
-    }
+void Ui::TickLEDs()
+{
+    led_animator_.Tick(hw_->GetNow());
 }
 
 uint8_t Ui::GetBankNum()
@@ -1095,6 +1208,19 @@ uint8_t Ui::GetBankNum()
     return bank_num_;
 }
 
+uint8_t Ui::GetPageNum()
+{
+    // Pages are the Z axis of a bank
+    return static_cast<uint8_t>(params[POT_Z].Value() + 0.5f);
+}
+
+Ui::CaptureRequest Ui::TakeCaptureRequest()
+{
+    const CaptureRequest request = capture_request_;
+    capture_request_             = CAPTURE_NONE;
+    return request;
+}
+
 void Ui::SetBanksMax(uint8_t max_banks)
 {
     max_banks_ = max_banks;
@@ -1105,40 +1231,58 @@ void Ui::SetWavesLoaded(bool loaded)
     waves_loaded_ = loaded;
 }
 
-bool Ui::isButtonPressed(uint8_t idx)
+bool Ui::isButtonUp(uint8_t idx)
 {
     if(idx > SW_LAST)
     {
         return false;
     }
-    return hw_->buttons[idx].isPressed();
+    return !hw_->buttons.IsDown(idx);
 }
 
-bool Ui::isButtonReleased(uint8_t idx)
+bool Ui::isButtonDown(uint8_t idx)
 {
     if(idx > SW_LAST)
     {
         return false;
     }
-    return hw_->buttons[idx].isReleased();
+    return hw_->buttons.IsDown(idx);
 }
 
-bool Ui::isButtonUp(uint8_t idx)
+bool Ui::PopTap(ButtonEvent& event)
 {
-    if(idx > SW_LAST)
+    while(hw_->buttons.Pop(event))
     {
-        return false;
+        const uint8_t bit = 1 << event.button;
+        if(event.type == ButtonEvent::LONG_HOLD)
+        {
+            long_held_ |= bit;
+        }
+        else if(event.type == ButtonEvent::RELEASE)
+        {
+            // A long hold (e.g. for a hot reload) is not a tap
+            const bool tap = !(long_held_ & bit);
+            long_held_ &= ~bit;
+            if(tap)
+            {
+                return true;
+            }
+        }
     }
-    return hw_->buttons[idx].isUp();
+    return false;
 }
 
-bool Ui::isButtonDown(uint8_t idx)
+bool Ui::TakeRelease(uint8_t idx)
 {
-    if(idx > SW_LAST)
+    ButtonEvent event;
+    while(PopTap(event))
     {
-        return false;
+        if(event.button == idx)
+        {
+            return true;
+        }
     }
-    return hw_->buttons[idx].isDown();
+    return false;
 }
 
 float ipiConverge(const float factors[], size_t idx, float freq, float spread)
@@ -1165,6 +1309,33 @@ float ipiConverge(const float factors[], size_t idx, float freq, float spread)
     return freq * ratio_interpolated;
 }
 
+/*
+    Voices stacked on each output follow the same spread as the outputs:
+    voices 0-3 take the four ratios of the spread type and 4-7 repeat them
+    an octave up. At zero spread that collapses to unison, so every voice
+    but the first is also detuned a little, alternating sharp and flat.
+*/
+void Ui::UpdateVoices(float spread)
+{
+    // Detune of the outermost pair of voices, in semitones
+    static constexpr float kUnisonDetune = 0.15f;
+
+    const size_t count = state_->voices;
+
+    voice_spread_.count    = count;
+    voice_spread_.ratio[0] = 1.0f;
+    for(size_t v = 1; v < count; v++)
+    {
+        float ratio = calculateSpread(v % 4, v < 4 ? 1.0f : 2.0f, spread);
+
+        float semitones = kUnisonDetune * static_cast<float>((v + 1) / 2)
+                          / static_cast<float>(count / 2);
+        ratio *= stmlib::SemitonesToRatio(v & 1 ? semitones : -semitones);
+
+        voice_spread_.ratio[v] = ratio;
+    }
+}
+
 float Ui::calculateSpread(size_t idx, float freq, float spread)
 {
     switch(spread_type_)
@@ -3,8 +3,11 @@
 #include <array>
 
 #include "daisy.h"
+#include "src/adc_scheduler.h"
 #include "src/app_state.h"
+#include "src/cv_stream.h"
 #include "src/hardware/fourSeasBoard.h"
+#include "src/led_animator.h"
 #include "src/parameter_24.h"
 #include "src/params.h"
 #include "src/settings.h"
@@ -25,6 +28,18 @@ constexpr inline uint8_t crossfade(uint8_t a, uint8_t b, float amount)
     return static_cast<uint8_t>(a + (amount * (b - a)));
 }
 
+// One bit per driver channel, for LedAnimator groups
+template <typename Channels>
+constexpr uint64_t ChannelMask(const Channels& channels)
+{
+    uint64_t mask = 0;
+    for(auto channel : channels)
+    {
+        mask |= uint64_t{1} << channel;
+    }
+    return mask;
+}
+
 class Ui
 {
   public:
@@ -223,17 +238,37 @@ class Ui
         LED_B_Z_SPREAD,
     };
 
+    // Wavetable capture asked for from the panel, see WaveCapture
+    enum CaptureRequest
+    {
+        CAPTURE_NONE,
+        CAPTURE,
+        CAPTURE_AND_SAVE,
+    };
+
     Ui() {}
     ~Ui() {}
 
     void           Init(FourSeasHW*                             hw,
                         daisy::PersistentStorage<SettingsData>* settingsStorage,
                         daisy::PersistentStorage<AppState>*     appStateStorage);
+
+    /**
+    Applies the calibration to the hardware controls and sets up the
+    params that read them. Init() does this; call it again after the
+    controls change (new audio rate, new calibration), with audio stopped.
+    */
+    void           InitControls();
     void           Calibrate();
     bool           Process();
     void           UpdateParams();
-    Params::Values GetParams(size_t idx);
+    const ParamValues& GetTargets(size_t idx) const { return targets_[idx]; }
+    const CvRamps&     GetCvRamps() const { return cv_ramps_; }
+    const VoiceSpread& GetVoices() const { return voice_spread_; }
+    const AdcScheduler& GetAdcScheduler() const { return adc_scheduler_; }
     uint8_t        GetBankNum();
+    uint8_t        GetPageNum();
+    CaptureRequest TakeCaptureRequest();
     void           SetBanksMax(uint8_t bank_num);
     void           SetWavesLoaded(bool loaded);
 
@@ -247,17 +282,22 @@ class Ui
     void SetLEDsByValue(uint8_t val);
     void SetLEDsByChannel(const std::array<fourseas::Ui::LEDs, 12> chan,
                           uint8_t                                  val);
-    bool isButtonPressed(uint8_t idx);
-    bool isButtonReleased(uint8_t idx);
     bool isButtonUp(uint8_t idx);
     bool isButtonDown(uint8_t idx);
     void SetSpreadType(float switch_mode);
+
+    // These start an animation and return straight away; UpdateLEDs()
+    // leaves the LEDs alone until it is done
     void StartupLEDSequence();
     void FadeBankLED(size_t bank_index);
     void FadeToColor(uint8_t  target_r,
                      uint8_t  target_g,
                      uint8_t  target_b,
-                     uint32_t duration_ms);
+                     uint16_t duration_ms,
+                     uint8_t  repeats = 1);
+
+    /** Runs the LED animations; from the GPIO timer interrupt */
+    void TickLEDs();
 
     Parameter24      cvs[CV_LAST];
     daisy::Parameter params[DSY_PARAM_LAST];
@@ -268,15 +308,35 @@ class Ui
 
   private:
     float calculateSpread(size_t idx, float freq, float spread);
+    void  BuildCvRamps(size_t size);
+    void  UpdateVoices(float spread);
+
+    void HandleRelease(const ButtonEvent& event);
+
+    // Next button released from a tap rather than a long hold, if any
+    bool PopTap(ButtonEvent& event);
+
+    // Drops taps until one on `idx`; false once none are left
+    bool TakeRelease(uint8_t idx);
+
+    static LedAnimator::Group AllRgbLeds();
 
     FourSeasHW*            hw_;
     float                  freq_pots_;
-    Params                 synth_params_[4];
+    ParamValues            targets_[4];
+    CvStream               cv_stream_;
+    AdcScheduler           adc_scheduler_;
+    CvRamps                cv_ramps_;
+    VoiceSpread            voice_spread_;
     uint8_t                max_banks_ = 1;
     uint8_t                bank_num_;
     AppState::SPREAD_TYPES spread_type_;
     bool                   lock_tuning_;
+    bool                   lock_shift_used_ = false;
+    CaptureRequest         capture_request_ = CAPTURE_NONE;
     bool                   waves_loaded_ = false;
+    uint8_t                long_held_ = 0; // bit n: LONG_HOLD seen
+    LedAnimator            led_animator_;
 
 
     static constexpr std::array<std::array<LEDs, 3>, NUM_RGB_LEDS> bank_leds_
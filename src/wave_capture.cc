@@ -0,0 +1,361 @@
+#include "wave_capture.h"
+
+#include <algorithm>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+using namespace fourseas;
+
+namespace
+{
+// Canonical header of a PCM WAV file
+struct WavHeader
+{
+    char     riff[4];
+    uint32_t file_size;
+    char     wave[4];
+    char     fmt[4];
+    uint32_t fmt_size;
+    uint16_t format;
+    uint16_t channels;
+    uint32_t sample_rate;
+    uint32_t byte_rate;
+    uint16_t block_align;
+    uint16_t bits_per_sample;
+    char     data[4];
+    uint32_t data_size;
+};
+static_assert(sizeof(WavHeader) == 44, "WAV header must be 44 bytes");
+} // namespace
+
+void WaveCapture::Init(float* scratch,
+                       float* staging,
+                       size_t wave_size,
+                       size_t num_waves,
+                       float  sample_rate)
+{
+    scratch_     = scratch;
+    staging_     = staging;
+    page_        = nullptr;
+    wave_size_   = wave_size;
+    num_waves_   = num_waves;
+    length_      = wave_size * num_waves;
+    sample_rate_ = static_cast<uint32_t>(sample_rate);
+    min_period_  = static_cast<size_t>(sample_rate / kMaxPitchHz);
+    max_period_  = static_cast<size_t>(sample_rate / kMinPitchHz);
+    write_pos_   = 0;
+    wave_        = 0;
+    save_        = false;
+    state_       = IDLE;
+}
+
+bool WaveCapture::Start(float* page, const char* path)
+{
+    if(state_ != IDLE)
+    {
+        return false;
+    }
+
+    page_ = page;
+    save_ = path != nullptr;
+    if(save_)
+    {
+        strncpy(path_, path, sizeof(path_) - 1);
+        path_[sizeof(path_) - 1] = '\0';
+    }
+
+    wave_      = 0;
+    write_pos_ = 0;
+    state_     = RECORDING;
+    return true;
+}
+
+void WaveCapture::Record(const float* in, size_t size)
+{
+    if(state_ != RECORDING)
+    {
+        return;
+    }
+
+    size = std::min(size, length_ - write_pos_);
+    memcpy(&scratch_[write_pos_], in, size * sizeof(float));
+    write_pos_ += size;
+
+    if(write_pos_ >= length_)
+    {
+        state_ = SLICING;
+    }
+}
+
+bool WaveCapture::Process()
+{
+    switch(state_)
+    {
+        case SLICING:
+        {
+            SliceWave(wave_);
+            if(++wave_ == num_waves_)
+            {
+                wave_  = 0;
+                peak_  = 0.0f;
+                state_ = NORMALISING;
+            }
+            return false;
+        }
+        case NORMALISING:
+        {
+            // First pass removes DC and finds the peak, second one scales
+            if(wave_ < num_waves_)
+            {
+                RemoveDc(wave_);
+            }
+            else if(peak_ > 1e-6f)
+            {
+                const size_t first = (wave_ - num_waves_) * wave_size_;
+                float*       wave  = &staging_[first];
+                const float  gain  = 1.0f / peak_;
+                for(size_t i = 0; i < wave_size_; i++)
+                {
+                    wave[i] *= gain;
+                }
+            }
+
+            if(++wave_ < 2 * num_waves_)
+            {
+                return false;
+            }
+
+            // Played from here while the page is copied over
+            wave_  = 0;
+            state_ = COPYING;
+            return true;
+        }
+        case COPYING:
+        {
+            memcpy(&page_[wave_ * wave_size_],
+                   &staging_[wave_ * wave_size_],
+                   wave_size_ * sizeof(float));
+            if(++wave_ < num_waves_)
+            {
+                return false;
+            }
+
+            wave_  = 0;
+            state_ = save_ && OpenFile() ? SAVING : IDLE;
+            return true;
+        }
+        case SAVING:
+        {
+            if(!SaveWave(wave_))
+            {
+                DiscardFile();
+                state_ = IDLE;
+            }
+            else if(++wave_ == num_waves_)
+            {
+                f_close(&file_);
+                state_ = IDLE;
+            }
+            return false;
+        }
+        default: return false;
+    }
+}
+
+void WaveCapture::Abort()
+{
+    if(state_ == SAVING)
+    {
+        DiscardFile();
+    }
+    state_ = IDLE;
+}
+
+void WaveCapture::SliceWave(size_t wave)
+{
+    float*       out   = &staging_[wave * wave_size_];
+    const size_t start = wave * wave_size_;
+
+    // The pitch search reads kWindow + max_period_ samples on, and the
+    // cycle up to two periods
+    const size_t search
+        = std::min(start, length_ - kWindow - max_period_ - 1);
+    const size_t period = DetectPeriod(&scratch_[search]);
+
+    if(period == 0)
+    {
+        // Unpitched: the stretch itself, fixed length
+        memcpy(out, &scratch_[start], wave_size_ * sizeof(float));
+        return;
+    }
+
+    // Start the cycle on a rising zero crossing so it loops cleanly
+    size_t begin = search;
+    for(size_t i = search; i < search + period; i++)
+    {
+        if(scratch_[i] <= 0.0f && scratch_[i + 1] > 0.0f)
+        {
+            begin = i + 1;
+            break;
+        }
+    }
+    Resample(&scratch_[begin], period, out, wave_size_);
+}
+
+/*
+    YIN: the difference between the signal and a copy delayed by tau,
+    normalised by its running mean. The period is the bottom of the first
+    dip under kPitchThreshold, or 0 if there is none.
+*/
+size_t WaveCapture::DetectPeriod(const float* x) const
+{
+    float  running = 0.0f;
+    float  best    = kPitchThreshold;
+    size_t period  = 0;
+
+    for(size_t tau = 1; tau <= max_period_; tau++)
+    {
+        float difference = 0.0f;
+        for(size_t j = 0; j < kWindow; j++)
+        {
+            const float delta = x[j] - x[j + tau];
+            difference += delta * delta;
+        }
+        running += difference;
+
+        if(tau < min_period_ || running <= 0.0f)
+        {
+            continue;
+        }
+
+        const float normalised
+            = difference * static_cast<float>(tau) / running;
+        if(normalised < best)
+        {
+            best   = normalised;
+            period = tau;
+        }
+        else if(period != 0)
+        {
+            break;
+        }
+    }
+    return period;
+}
+
+void WaveCapture::RemoveDc(size_t wave)
+{
+    float* samples = &staging_[wave * wave_size_];
+
+    float sum = 0.0f;
+    for(size_t i = 0; i < wave_size_; i++)
+    {
+        sum += samples[i];
+    }
+    const float dc = sum / static_cast<float>(wave_size_);
+
+    for(size_t i = 0; i < wave_size_; i++)
+    {
+        samples[i] -= dc;
+        peak_ = std::max(peak_, fabsf(samples[i]));
+    }
+}
+
+// Linear resampling of one cycle; reads in[in_size] to close the loop
+void WaveCapture::Resample(const float* in,
+                           size_t       in_size,
+                           float*       out,
+                           size_t       out_size)
+{
+    const float step = static_cast<float>(in_size) / out_size;
+    for(size_t j = 0; j < out_size; j++)
+    {
+        const float  position   = j * step;
+        const size_t integral   = static_cast<size_t>(position);
+        const float  fractional = position - integral;
+        out[j] = in[integral] + (in[integral + 1] - in[integral]) * fractional;
+    }
+}
+
+void WaveCapture::BackupPath(char* backup) const
+{
+    snprintf(backup, kBackupPathSize, "%s.bak", path_);
+}
+
+bool WaveCapture::OpenFile()
+{
+    // Keep whatever was there
+    char backup[kBackupPathSize];
+    BackupPath(backup);
+    f_unlink(backup);
+    f_rename(path_, backup);
+
+    if(f_open(&file_, path_, FA_WRITE | FA_CREATE_ALWAYS) != FR_OK)
+    {
+        f_rename(backup, path_);
+        return false;
+    }
+
+    const uint32_t data_size = length_ * sizeof(int16_t);
+
+    WavHeader header;
+    memcpy(header.riff, "RIFF", 4);
+    header.file_size = sizeof(WavHeader) - 8 + data_size;
+    memcpy(header.wave, "WAVE", 4);
+    memcpy(header.fmt, "fmt ", 4);
+    header.fmt_size        = 16;
+    header.format          = 1; // PCM
+    header.channels        = 1;
+    header.sample_rate     = sample_rate_;
+    header.byte_rate       = header.sample_rate * sizeof(int16_t);
+    header.block_align     = sizeof(int16_t);
+    header.bits_per_sample = 16;
+    memcpy(header.data, "data", 4);
+    header.data_size = data_size;
+
+    UINT written;
+    if(f_write(&file_, &header, sizeof(header), &written) != FR_OK
+       || written != sizeof(header))
+    {
+        DiscardFile();
+        return false;
+    }
+    return true;
+}
+
+// A save cut short: delete what was written and put the old file back
+void WaveCapture::DiscardFile()
+{
+    f_close(&file_);
+    f_unlink(path_);
+
+    char backup[kBackupPathSize];
+    BackupPath(backup);
+    f_rename(backup, path_);
+}
+
+bool WaveCapture::SaveWave(size_t wave)
+{
+    const float* samples = &staging_[wave * wave_size_];
+
+    int16_t chunk[256];
+    for(size_t i = 0; i < wave_size_; i += 256)
+    {
+        const size_t count = std::min(wave_size_ - i, size_t(256));
+        for(size_t j = 0; j < count; j++)
+        {
+            const float sample = std::clamp(samples[i + j], -1.0f, 1.0f);
+            chunk[j]           = static_cast<int16_t>(sample * 32767.0f);
+        }
+
+        const UINT bytes = count * sizeof(int16_t);
+        UINT       written;
+        if(f_write(&file_, chunk, bytes, &written) != FR_OK
+           || written != bytes)
+        {
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,141 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "fatfs.h"
+
+namespace fourseas
+{
+/**
+    Samples an audio input into one page of a wavetable bank.
+
+    The audio callback copies the input straight from the codec buffers
+    into a scratch recording in SDRAM, one page long. Everything after that
+    runs from the main loop, one wave per Process() call, so the audio
+    never waits on it:
+
+    1. SLICING: every wave of the page is cut from its own stretch of the
+       recording into a second, staging buffer. Where a pitch is found, one
+       period is resampled to the wave length; otherwise the stretch is
+       used as it is (fixed length).
+    2. NORMALISING: DC is removed from every wave, then the whole page is
+       scaled to a peak of 1, keeping the levels between waves.
+    3. COPYING: the staged waves are copied over the page.
+    4. SAVING, if asked for: the page is written to `path` as a 16-bit mono
+       WAV that LoadWavetables() reads back. An existing file is kept with
+       a .bak extension, and put back if the new one is not finished.
+
+    Nothing that could be playing is written while it is half built: the
+    page is only copied over once the oscillators have been pointed at the
+    staged copy, and they are pointed back once it is done. Process() says
+    when, and GetOutput() where.
+*/
+class WaveCapture
+{
+  public:
+    enum State
+    {
+        IDLE,
+        RECORDING,
+        SLICING,
+        NORMALISING,
+        COPYING,
+        SAVING,
+    };
+
+    WaveCapture() {}
+    ~WaveCapture() {}
+
+    /**
+    \param scratch SDRAM buffer of `wave_size * num_waves` samples, for
+    the recording
+    \param staging another one that size, for the waves cut from it
+    \param wave_size samples per wave
+    \param num_waves waves per page
+    \param sample_rate of the input, for the pitch search and the WAV file
+    */
+    void Init(float* scratch,
+              float* staging,
+              size_t wave_size,
+              size_t num_waves,
+              float  sample_rate);
+
+    /**
+    Starts recording into `page`. With a `path` (up to 31 characters), the
+    page is also written to the SD card once it is done. Ignored unless
+    IDLE.
+    */
+    bool Start(float* page, const char* path = nullptr);
+
+    /** Audio side. Call once per block with the input being captured. */
+    void Record(const float* in, size_t size);
+
+    /**
+    Main loop side. Does one step of the work after recording. Returns
+    true when the finished waves move, between audio blocks and before
+    anything more is written: once when they are complete in staging, and
+    again once they have been copied over the page.
+    */
+    bool Process();
+
+    /**
+    Drops whatever is in progress and goes back to IDLE. A save that has
+    not finished is deleted and the file it replaced put back, so this
+    must run before the SD card goes away. Call with audio stopped.
+    */
+    void Abort();
+
+    /** Where the finished waves are, the last time Process() said so */
+    float* GetOutput() const { return state_ == COPYING ? staging_ : page_; }
+
+    State GetState() const { return state_; }
+
+  private:
+    // Pitch search range; Init() turns it into periods at the input rate
+    static constexpr float kMaxPitchHz = 2000.0f;
+    static constexpr float kMinPitchHz = 47.0f;
+
+    // Length of the stretch compared against its delayed copy
+    static constexpr size_t kWindow = 1024;
+
+    // Highest YIN difference that still counts as pitched
+    static constexpr float kPitchThreshold = 0.15f;
+
+    // The save path, and the same with .bak on the end
+    static constexpr size_t kPathSize       = 32;
+    static constexpr size_t kBackupPathSize = kPathSize + 4;
+
+    void   SliceWave(size_t wave);
+    size_t DetectPeriod(const float* x) const;
+    void   RemoveDc(size_t wave);
+    bool   SaveWave(size_t wave);
+    bool   OpenFile();
+    void   DiscardFile();
+    void   BackupPath(char* backup) const;
+
+    static void
+    Resample(const float* in, size_t in_size, float* out, size_t out_size);
+
+    float*   scratch_;
+    float*   staging_;
+    float*   page_;
+    size_t   wave_size_;
+    size_t   num_waves_;
+    size_t   length_;
+    uint32_t sample_rate_;
+    size_t   min_period_;
+    size_t   max_period_;
+
+    volatile State state_ = IDLE;
+    size_t         write_pos_;
+
+    size_t wave_;
+    float  peak_;
+
+    bool save_;
+    char path_[kPathSize];
+    FIL  file_;
+};
+
+} // namespace fourseas
@@ -29,12 +29,16 @@
 #pragma once
 
 #include <algorithm>
+#include <string.h>
 
 #include "stmlib/dsp/dsp.h"
 
 #include "src/constants.h"
 #include "src/params.h"
 #include "src/app_state.h"
+#include "src/halfband.h"
+#include "src/phase_interpolation.h"
+#include "src/sync_detector.h"
 
 
 namespace fourseas
@@ -57,12 +61,65 @@ inline float Clamp(float x, float amount)
     return x + 0.5f;
 }
 
-template <size_t wavetable_size,
-          bool   uses_sync       = false,
-          bool   uses_modulation = false>
+// 2-point PolyBLEP residuals for a discontinuity `t` samples before the
+// current sample. "This" corrects the sample before the discontinuity,
+// "Next" the one after it. The integrated versions correct a change of slope.
+inline float ThisBlepSample(float t)
+{
+    return 0.5f * t * t;
+}
+
+inline float NextBlepSample(float t)
+{
+    t = 1.0f - t;
+    return -0.5f * t * t;
+}
+
+inline float ThisIntegratedBlepSample(float t)
+{
+    return t * t * t * (1.0f / 6.0f);
+}
+
+inline float NextIntegratedBlepSample(float t)
+{
+    t = 1.0f - t;
+    return t * t * t * (1.0f / 6.0f);
+}
+
+// 2^x for the audio-rate FM. The fractional part goes through a cubic fitted
+// to 2^f on [0, 1) with both ends pinned (max error ~0.25 cents, continuous
+// across octaves) and the integral part is added to the exponent directly.
+inline float FastExp2(float x)
+{
+    const float integral = floorf(x);
+    const float f        = x - integral;
+
+    float p = 1.0f + f * (0.6959285f + f * (0.2249463f + f * 0.0791252f));
+
+    // Unsigned, as a negative octave count shifted left is undefined
+    uint32_t bits;
+    memcpy(&bits, &p, sizeof(bits));
+    bits += static_cast<uint32_t>(static_cast<int32_t>(integral)) << 23;
+    memcpy(&p, &bits, sizeof(bits));
+    return p;
+}
+
+/**
+\tparam PhaseInterpolation how a wave is read between two samples, see
+src/phase_interpolation.h
+*/
+template <size_t   wavetable_size,
+          bool     uses_sync          = false,
+          bool     uses_modulation    = false,
+          typename PhaseInterpolation = LinearPhase>
 class WavetableOscillator
 {
+    static_assert((wavetable_size & (wavetable_size - 1)) == 0,
+                  "wavetable_size must be a power of two");
+
   public:
+    using Schema = ParamSchema<uses_modulation>;
+
     WavetableOscillator() = default;
     ~WavetableOscillator() {}
 
@@ -72,7 +129,28 @@ class WavetableOscillator
 
         wavetable_ = wavetable;
         all_waves_ = wavetable;
-        prev_sync_ = false;
+
+        sync_detector_.Init();
+        sync_edges_.count = 0;
+        delayed_sample_   = 0.0f;
+
+        decimator_2x_.Init(kHalfband39);
+        decimator_4x_.Init(kHalfband15);
+        oversampling_active_ = false;
+
+        voices_     = 1;
+        voice_gain_ = 1.0f;
+
+        fade_active_ = false;
+        fade_from_   = wavetable;
+
+        blend_dirty_  = true;
+        blend_settle_ = 0;
+        blend_key_    = {};
+
+        params_.Init(&values_);
+
+        PhaseInterpolation::Init();
     }
 
     float
@@ -82,29 +160,566 @@ class WavetableOscillator
         return InterpolateWave(wave, phase_integral, phase_fractional);
     }
 
-    void SetBank(size_t bank_idx) { wavetable_ = &all_waves_[bank_idx * 512]; }
+    /**
+    Switches to another bank. With `fade_samples`, the old bank is faded out
+    with an equal-power crossfade instead of being cut off, which costs one
+    extra uncached read per voice until the fade ends.
+    */
+    void SetBank(size_t bank_idx, size_t fade_samples = 0)
+    {
+        float** waves = &all_waves_[bank_idx * 512];
+        if(waves == wavetable_)
+        {
+            return;
+        }
 
-    void Render(const OscillatorParams& params, float* out)
+        if(fade_samples == 0)
+        {
+            fade_active_ = false;
+        }
+        else
+        {
+            if(!fade_active_)
+            {
+                fade_from_     = wavetable_;
+                fade_position_ = 0.0f;
+            }
+            else if(fade_position_ >= 0.5f)
+            {
+                // Already mid-fade: whichever bank is louder stays at its
+                // current gain and only the quieter one is swapped out.
+                fade_from_     = wavetable_;
+                fade_position_ = 1.0f - fade_position_;
+            }
+            fade_increment_ = 1.0f / static_cast<float>(fade_samples);
+            fade_active_    = true;
+            AdvanceFade(0.0f);
+        }
+
+        wavetable_   = waves;
+        blend_dirty_ = true;
+    }
+
+    // Makes a running bank fade end within the next `samples` samples
+    void LimitFade(size_t samples)
     {
-        const float f0          = params.values.frequency;
-        float       x           = params.values.x;
-        float       y           = params.values.y;
-        float       z           = params.values.z;
-        float       mod_amount  = params.values.osc_mod_amount;
-        bool        interpolate = params.interpolate;
-        uint8_t     mod_state   = params.mod_state;
-        float       mod_input   = params.mod_input;
+        if(fade_active_)
+        {
+            const float remaining = 1.0f - fade_position_;
+            fade_increment_       = std::max(
+                fade_increment_,
+                remaining / static_cast<float>(std::max(samples, size_t(1))));
+        }
+    }
 
-        uint8_t sync_state = params.sync_state;
-        bool    sync_input = params.sync_input;
+    // Drops the cached blended wave, for when the waves under it change
+    void InvalidateBlend() { blend_dirty_ = true; }
 
+    /**
+    Corner waves a read at this morph position blends, 1 to 8, with
+    OscillatorParams::interpolate as given. A direct read costs
+    PhaseInterpolation::kTaps taps per corner; a cached blend costs
+    kTaps whatever the corners.
+    */
+    static size_t CornersAt(float x, float y, float z, bool interpolate)
+    {
+        const uint8_t kernel = PositionMorph(x, y, z, interpolate).kernel;
+        return size_t(1) << __builtin_popcount(kernel);
+    }
+
+    // Sets the values this oscillator ramps to over the next `size` samples
+    void Update(const ParamValues& target, size_t size)
+    {
+        params_.Update(target, size);
+    }
+
+    // Keeps the frequency limit at kMaxFrequencyHz whatever the rate
+    void SetSampleRate(float sample_rate)
+    {
+        max_frequency_ = kMaxFrequencyHz / sample_rate;
+    }
+
+    /**
+    Renders 1 of every `factor` samples and linearly interpolates the rest.
+    Meant for LFO mode, where the output is sub-audio anyway; 1 disables it.
+    */
+    void SetDecimation(size_t factor)
+    {
+        factor = std::max(factor, size_t(1));
+        if(factor != decimation_)
+        {
+            decimation_         = factor;
+            decimation_counter_ = 0;
+        }
+    }
+
+    /**
+    Renders the WAVESHAPING and XOR modes at 1, 2 or 4 times the sample
+    rate. Both throw harmonics far past Nyquist; other modes ignore this.
+    */
+    void SetOversampling(size_t factor)
+    {
+        oversampling_ = factor >= 4 ? 4 : (factor >= 2 ? 2 : 1);
+    }
+
+    /**
+    Stacks `spread.count` voices on this output, but no more than `limit`.
+    Every voice reads the same morph, so the corner waves, weights and blend
+    cache are shared and an extra voice only costs one more wave read.
+    Ignored in WAVESHAPING mode, where the phase comes from the mod input.
+    */
+    void SetVoices(const VoiceSpread& spread, size_t limit)
+    {
+        size_t count = std::min(std::min(spread.count, limit), kMaxVoices);
+        count        = std::max(count, size_t(1));
+
+        // New voices start spread around the cycle rather than in phase
+        // with the first one, which would comb on the way in
+        for(size_t v = voices_; v < count; v++)
+        {
+            voice_phase_[v] = Wrap(phase_ + kVoicePhaseStep * v);
+        }
+
+        if(count != voices_)
+        {
+            voices_     = count;
+            voice_gain_ = 1.0f / static_cast<float>(count);
+        }
+        std::copy(&spread.ratio[0], &spread.ratio[count], &voice_ratio_[0]);
+    }
+
+    void Render(const OscillatorParams& params,
+                const CvRamps&          cv,
+                float*                  out,
+                size_t                  size)
+    {
+        if constexpr(uses_sync)
+        {
+            sync_detector_.Process(params.sync_input, size, &sync_edges_);
+        }
+
+        if(decimation_ > 1)
+        {
+            RenderDecimated(params, cv, out, size);
+            return;
+        }
+
+        if constexpr(uses_modulation)
+        {
+            const bool oversample
+                = oversampling_ > 1
+                  && (params.mod_state == AppState::MOD_STATES::WAVESHAPING
+                      || params.mod_state == AppState::MOD_STATES::XOR);
+            if(oversample)
+            {
+                RenderOversampled(params, cv, out, size);
+                return;
+            }
+            oversampling_active_ = false;
+        }
+
+        // Run edge-free stretches without any sync test, then apply the
+        // sync mode on the first sample after each edge.
+        size_t i = 0;
+        for(size_t e = 0; e < sync_edges_.count; e++)
+        {
+            const size_t edge = sync_edges_.index[e];
+            for(; i < edge; i++)
+            {
+                params_.Next();
+                out[i] = RenderSample(
+                    params, cv, i, 1.0f, kNoSync, ModInput(params, i));
+            }
+            params_.Next();
+            blep_this_ = 0.0f;
+            blep_next_ = 0.0f;
+            out[i]     = RenderSample(params,
+                                  cv,
+                                  i,
+                                  1.0f,
+                                  sync_edges_.fraction[e],
+                                  ModInput(params, i));
+
+            // Smear the step and kink left by the sync over both neighbours
+            (i > 0 ? out[i - 1] : delayed_sample_) += blep_this_;
+            out[i] += blep_next_;
+            i++;
+        }
+        for(; i < size; i++)
+        {
+            params_.Next();
+            out[i] = RenderSample(
+                params, cv, i, 1.0f, kNoSync, ModInput(params, i));
+        }
 
+        if constexpr(uses_sync)
+        {
+            // One sample of delay, so that an edge on the first sample of a
+            // block can still correct the last sample of the previous one.
+            const float last = out[size - 1];
+            std::copy_backward(out, out + size - 1, out + size);
+            out[0]          = delayed_sample_;
+            delayed_sample_ = last;
+        }
+        next_sample_ = out[size - 1];
+    }
+
+  private:
+    void RenderDecimated(const OscillatorParams& params,
+                         const CvRamps&          cv,
+                         float*                  out,
+                         size_t                  size)
+    {
+        const float rate  = static_cast<float>(decimation_);
+        const float slope = 1.0f / rate;
+
+        size_t edge = 0;
+        for(size_t i = 0; i < size; i++)
+        {
+            // Parameters and sync are still tracked every sample so nothing
+            // is lost between the rendered points.
+            params_.Next();
+            if(edge < sync_edges_.count && sync_edges_.index[edge] == i)
+            {
+                sync_pending_ = true;
+                edge++;
+            }
+
+            if(decimation_counter_ == 0)
+            {
+                prev_sample_ = next_sample_;
+                // Sub-audio, so the sync is applied without correction
+                next_sample_  = RenderSample(params,
+                                            cv,
+                                            i,
+                                            rate,
+                                            sync_pending_ ? 0.0f : kNoSync,
+                                            ModInput(params, i));
+                sync_pending_ = false;
+            }
+            decimation_counter_++;
+
+            float t = static_cast<float>(decimation_counter_) * slope;
+            out[i]  = prev_sample_ + (next_sample_ - prev_sample_) * t;
+
+            if(decimation_counter_ >= decimation_)
+            {
+                decimation_counter_ = 0;
+            }
+        }
+    }
+
+    /**
+    Renders `oversampling_` sub-samples per output sample and brings them
+    back down through one or two halfband stages. The audio-rate mod input
+    is linearly interpolated across the sub-samples. Sync is applied on the
+    first sub-sample after an edge; at this rate it needs no correction.
+    */
+    void RenderOversampled(const OscillatorParams& params,
+                           const CvRamps&          cv,
+                           float*                  out,
+                           size_t                  size)
+    {
+        if(!oversampling_active_)
+        {
+            decimator_2x_.Reset();
+            decimator_4x_.Reset();
+            oversampling_active_ = true;
+        }
+
+        const size_t factor = oversampling_;
+        const float  rate   = 1.0f / static_cast<float>(factor);
+
+        float  previous_mod = previous_mod_input_;
+        size_t edge         = 0;
+        for(size_t i = 0; i < size; i++)
+        {
+            params_.Next();
+
+            float sync_time = kNoSync;
+            if(edge < sync_edges_.count && sync_edges_.index[edge] == i)
+            {
+                sync_time = 0.0f;
+                edge++;
+            }
+
+            const float mod = params.mod_input[i];
+            float       sub[kMaxOversampling] = {};
+            for(size_t j = 0; j < factor; j++)
+            {
+                float t   = static_cast<float>(j + 1) * rate;
+                float m   = previous_mod + (mod - previous_mod) * t;
+                sub[j]    = RenderSample(params, cv, i, rate, sync_time, m);
+                sync_time = kNoSync;
+            }
+            previous_mod = mod;
+
+            if(factor == 4)
+            {
+                sub[0] = decimator_4x_.Process(sub[0], sub[1]);
+                sub[1] = decimator_4x_.Process(sub[2], sub[3]);
+            }
+            out[i] = decimator_2x_.Process(sub[0], sub[1]);
+        }
+        previous_mod_input_ = previous_mod;
+
+        // Nothing is held back here, keep the sync path's delay line primed
+        delayed_sample_ = out[size - 1];
+        next_sample_    = out[size - 1];
+    }
+
+    static inline float ModInput(const OscillatorParams& params, size_t i)
+    {
+        if constexpr(uses_modulation)
+        {
+            return params.mod_input[i];
+        }
+        return 0.0f;
+    }
+
+    // Morph corners and weights for one sample
+    struct Morph
+    {
+        int   x_integral, y_integral, z_integral;
+        float x_fractional, y_fractional, z_fractional;
+
+        // Bit n set when axis n (x, y, z) actually blends two waves
+        uint8_t kernel;
+    };
+
+    /**
+    Classifies each axis as fixed (weight 0), saturated (weight 1, moved onto
+    the next wave) or blending. With wave interpolation off most weights end
+    up on 0 or 1, so the read only needs 1, 2 or 4 of the 8 corners.
+    */
+    static inline Morph MakeMorph(int   x_integral,
+                                  int   y_integral,
+                                  int   z_integral,
+                                  float x_fractional,
+                                  float y_fractional,
+                                  float z_fractional)
+    {
+        Morph morph = {x_integral,
+                       y_integral,
+                       z_integral,
+                       x_fractional,
+                       y_fractional,
+                       z_fractional,
+                       0};
+        SnapAxis(&morph.x_integral, &morph.x_fractional);
+        SnapAxis(&morph.y_integral, &morph.y_fractional);
+        SnapAxis(&morph.z_integral, &morph.z_fractional);
+        morph.kernel = (morph.x_fractional > 0.0f ? 1 : 0)
+                       | (morph.y_fractional > 0.0f ? 2 : 0)
+                       | (morph.z_fractional > 0.0f ? 4 : 0);
+        return morph;
+    }
+
+    // Morph for a position, with OscillatorParams::interpolate as given
+    static inline Morph
+    PositionMorph(float x, float y, float z, bool interpolate)
+    {
         // flip this so that true actually equals true
         interpolate = !interpolate;
 
+        // int32_t x_integral = static_cast<int32_t>(x);
+        // float x_fractional = x - static_cast<float>(x_integral);
+        MAKE_INTEGRAL_FRACTIONAL(x);
+        MAKE_INTEGRAL_FRACTIONAL(y);
+        MAKE_INTEGRAL_FRACTIONAL(z);
+
+        // Interpolation stuff
+        x_fractional
+            += interpolate * (Clamp(x_fractional, 16.0f) - x_fractional);
+        y_fractional
+            += interpolate * (Clamp(y_fractional, 16.0f) - y_fractional);
+        z_fractional
+            += interpolate * (Clamp(z_fractional, 16.0f) - z_fractional);
+
+        return MakeMorph(x_integral,
+                         y_integral,
+                         z_integral,
+                         x_fractional,
+                         y_fractional,
+                         z_fractional);
+    }
+
+    static inline void SnapAxis(int* integral, float* fractional)
+    {
+        if(*fractional >= 1.0f)
+        {
+            *integral += 1;
+            *fractional = 0.0f;
+        }
+    }
+
+    /**
+    Trilinear blend restricted to the axes that blend, reading each corner
+    through `tap(x, y, z)`. The other axes cost neither reads nor lerps.
+    */
+    template <bool blend_x, bool blend_y, bool blend_z, typename Tap>
+    static inline float BlendTaps(const Morph& morph, const Tap& tap)
+    {
+        const int z = morph.z_integral;
+
+        float a = BlendY<blend_x, blend_y>(morph, tap, z);
+        if constexpr(blend_z)
+        {
+            float b = BlendY<blend_x, blend_y>(morph, tap, z + 1);
+            a += (b - a) * morph.z_fractional;
+        }
+        return a;
+    }
+
+    template <bool blend_x, bool blend_y, typename Tap>
+    static inline float BlendY(const Morph& morph, const Tap& tap, int z)
+    {
+        float a = BlendX<blend_x>(morph, tap, morph.y_integral, z);
+        if constexpr(blend_y)
+        {
+            float b = BlendX<blend_x>(morph, tap, morph.y_integral + 1, z);
+            a += (b - a) * morph.y_fractional;
+        }
+        return a;
+    }
+
+    template <bool blend_x, typename Tap>
+    static inline float BlendX(const Morph& morph, const Tap& tap, int y, int z)
+    {
+        float a = tap(morph.x_integral, y, z);
+        if constexpr(blend_x)
+        {
+            float b = tap(morph.x_integral + 1, y, z);
+            a += (b - a) * morph.x_fractional;
+        }
+        return a;
+    }
+
+    // Corner readers for Blend(): interpolated at a phase, or at one index
+    struct PhaseTap
+    {
+        float** waves;
+        int32_t p_integral;
+        float   p_fractional;
+
+        inline float operator()(int x, int y, int z) const
+        {
+            const WaveSample sample{waves[x + y * 8 + z * kNumWavesPerBank]};
+            return PhaseInterpolation::Read(sample, p_integral, p_fractional);
+        }
+    };
+
+    struct WaveSample
+    {
+        const float* wave;
+
+        inline float operator()(int32_t index) const
+        {
+            return wave[index & (wavetable_size - 1)];
+        }
+    };
+
+    struct IndexTap
+    {
+        float** waves;
+        int32_t index;
+
+        inline float operator()(int x, int y, int z) const
+        {
+            return waves[x + y * 8 + z * kNumWavesPerBank][index];
+        }
+    };
+
+    template <typename Tap>
+    static inline float Blend(const Morph& morph, const Tap& tap)
+    {
+        switch(morph.kernel)
+        {
+            case 0: return BlendTaps<false, false, false>(morph, tap);
+            case 1: return BlendTaps<true, false, false>(morph, tap);
+            case 2: return BlendTaps<false, true, false>(morph, tap);
+            case 3: return BlendTaps<true, true, false>(morph, tap);
+            case 4: return BlendTaps<false, false, true>(morph, tap);
+            case 5: return BlendTaps<true, false, true>(morph, tap);
+            case 6: return BlendTaps<false, true, true>(morph, tap);
+            default: return BlendTaps<true, true, true>(morph, tap);
+        }
+    }
+
+    static constexpr float kNoSync = -1.0f;
+
+    // Depth of the audio-rate FM modes for a full-scale input at full amount
+    static constexpr float kExpFmOctaves  = 4.0f;
+    static constexpr float kLinearFmIndex = 4.0f;
+
+    // Golden ratio conjugate: keeps any number of voices apart in phase
+    static constexpr float kVoicePhaseStep = 0.618034f;
+
+    /**
+    \param rate number of output samples this one stands for
+    \param sync_time samples since a sync edge, or kNoSync. When set, the
+    residuals for the resulting discontinuity are left in blep_this_ and
+    blep_next_.
+    \param mod_input value of the mod input for this sample
+    */
+    float RenderSample(const OscillatorParams& params,
+                       const CvRamps&          cv,
+                       size_t                  i,
+                       float                   rate,
+                       float                   sync_time,
+                       float                   mod_input)
+    {
+        if(fade_active_)
+        {
+            AdvanceFade(rate);
+        }
+
+        const float frequency = values_.frequency * cv.fm_ratio[i];
+
+        float f0 = daisysp::fclamp(frequency, kMinFrequency, max_frequency_)
+                   * rate;
+        float x = daisysp::fclamp(values_.x + cv.x[i], 0.0f, 6.9999f);
+        float y = daisysp::fclamp(values_.y + cv.y[i], 0.0f, 6.9999f);
+        float z = daisysp::fclamp(values_.z + cv.z[i], 0.0f, 6.9999f);
+
+        float   mod_amount  = 0.0f;
+        bool    interpolate = params.interpolate;
+        uint8_t mod_state   = params.mod_state;
+
+        uint8_t sync_state = params.sync_state;
+
+        if constexpr(uses_modulation)
+        {
+            mod_amount = values_.osc_mod_amount;
+
+            if(mod_state == AppState::MOD_STATES::EXP_FM)
+            {
+                float depth   = fourseas::DeadZone(mod_amount, 0.01f);
+                float octaves = mod_input * depth * kExpFmOctaves;
+                f0 = daisysp::fclamp(frequency * FastExp2(octaves),
+                                     kMinFrequency,
+                                     max_frequency_)
+                     * rate;
+            }
+            else if(mod_state == AppState::MOD_STATES::LINEAR_FM)
+            {
+                // Through-zero: a negative frequency runs the phase backwards
+                float depth = fourseas::DeadZone(mod_amount, 0.01f);
+                float index = mod_input * depth * kLinearFmIndex;
+                f0 = daisysp::fclamp(frequency * (1.0f + index),
+                                     -max_frequency_,
+                                     max_frequency_)
+                     * rate;
+            }
+        }
+
+
         float phase = phase_;
 
-        phase += (is_flipped_ ? f0 : -f0);
+        const float increment = is_flipped_ ? f0 : -f0;
+        phase += increment;
+
+        float phase_offset = 0.0f;
 
         if constexpr(uses_modulation)
         {
@@ -112,7 +727,10 @@ class WavetableOscillator
             {
                 static constexpr float pmFactor = kMaxFrequency / 2.0f;
                 mod_amount = fourseas::DeadZone(mod_amount, 0.01f) * pmFactor;
-                phase += mod_input * mod_amount;
+                // The offset stays in the phase, so like f0 it is per
+                // output sample and scales with what this one stands for
+                phase_offset = mod_input * mod_amount * rate;
+                phase += phase_offset;
             }
             else if(mod_state == AppState::MOD_STATES::WAVESHAPING)
             {
@@ -122,8 +740,7 @@ class WavetableOscillator
 
                 if(mod_amount < 0.1f)
                 {
-                    *out = 0.0f;
-                    return;
+                    return 0.0f;
                 }
 
                 // Waveshaping calculation
@@ -142,85 +759,23 @@ class WavetableOscillator
             phase = phase - floorf(phase);
         }
 
+        const Morph morph = PositionMorph(x, y, z, interpolate);
+
         if constexpr(uses_sync)
         {
-            if(prev_sync_ == false && sync_input == true)
+            if(sync_time >= 0.0f)
             {
-                // TODO: experiment with PLL here for sync
-                // (though soft sync seems to work okay in cases)
-                switch(sync_state)
-                {
-                    case AppState::SYNC_MODES::HARD:
-                    {
-                        phase = 0.0f;
-                        break;
-                    }
-                    // Orange
-                    case AppState::SYNC_MODES::SOFT:
-                    {
-                        if(phase <= 0.25f)
-                        {
-                            phase = 0.0f;
-                        }
-                        break;
-                    }
-                    case AppState::SYNC_MODES::FLIP:
-                    {
-                        is_flipped_ = !is_flipped_;
-                        break;
-                    }
-                    default: break;
-                }
+                phase = Sync(morph, sync_state, phase, f0, sync_time);
             }
-            prev_sync_ = sync_input;
         }
 
-        // int32_t x_integral = static_cast<int32_t>(x);
-        // float x_fractional = x - static_cast<float>(x_integral);
-        MAKE_INTEGRAL_FRACTIONAL(x);
-        MAKE_INTEGRAL_FRACTIONAL(y);
-        MAKE_INTEGRAL_FRACTIONAL(z);
-
-        // Interpolation stuff
-        x_fractional
-            += interpolate * (Clamp(x_fractional, 16.0f) - x_fractional);
-        y_fractional
-            += interpolate * (Clamp(y_fractional, 16.0f) - y_fractional);
-        z_fractional
-            += interpolate * (Clamp(z_fractional, 16.0f) - z_fractional);
-
-        // TODO: ensure that this "off by one" thing is correct and glitch-free
-        const float p = phase * float(wavetable_size) - 1;
-        MAKE_INTEGRAL_FRACTIONAL(p);
-
-        int x0 = x_integral;
-        int x1 = x_integral + 1;
-        int y0 = y_integral;
-        int y1 = y_integral + 1;
-        int z0 = z_integral;
-        int z1 = z_integral + 1;
-
-        float x0y0z0 = ReadWave(x0, y0, z0, p_integral, p_fractional);
-        float x1y0z0 = ReadWave(x1, y0, z0, p_integral, p_fractional);
-        float xy0z0  = x0y0z0 + (x1y0z0 - x0y0z0) * x_fractional;
-
-        float x0y1z0 = ReadWave(x0, y1, z0, p_integral, p_fractional);
-        float x1y1z0 = ReadWave(x1, y1, z0, p_integral, p_fractional);
-        float xy1z0  = x0y1z0 + (x1y1z0 - x0y1z0) * x_fractional;
-
-        float xyz0 = xy0z0 + (xy1z0 - xy0z0) * y_fractional;
-
-        float x0y0z1 = ReadWave(x0, y0, z1, p_integral, p_fractional);
-        float x1y0z1 = ReadWave(x1, y0, z1, p_integral, p_fractional);
-        float xy0z1  = x0y0z1 + (x1y0z1 - x0y0z1) * x_fractional;
-
-        float x0y1z1 = ReadWave(x0, y1, z1, p_integral, p_fractional);
-        float x1y1z1 = ReadWave(x1, y1, z1, p_integral, p_fractional);
-        float xy1z1  = x0y1z1 + (x1y1z1 - x0y1z1) * x_fractional;
-
-        float xyz1 = xy0z1 + (xy1z1 - xy0z1) * y_fractional;
+        float mix = ReadBanks(morph, phase);
 
-        float mix = xyz0 + (xyz1 - xyz0) * z_fractional;
+        if(voices_ > 1 && mod_state != AppState::MOD_STATES::WAVESHAPING)
+        {
+            mix = RenderVoices(
+                morph, mix, increment, phase_offset, sync_state, sync_time);
+        }
 
         if constexpr(uses_modulation)
         {
@@ -247,18 +802,326 @@ class WavetableOscillator
             }
         }
 
-        *out = mix;
-
         phase_ = phase;
+
+        return mix;
+    }
+
+    /**
+    Advances and reads voices 1 and up, adds them to `mix` (voice 0) and
+    scales the sum. Only the phases differ from voice 0: `increment` is
+    voice 0's phase step and `offset` its phase modulation.
+    */
+    float RenderVoices(const Morph& morph,
+                       float        mix,
+                       float        increment,
+                       float        offset,
+                       uint8_t      sync_state,
+                       float        sync_time)
+    {
+        for(size_t v = 1; v < voices_; v++)
+        {
+            const float voice_increment = increment * voice_ratio_[v];
+
+            float phase = Wrap(voice_phase_[v] + voice_increment + offset);
+
+            if constexpr(uses_sync)
+            {
+                if(sync_time >= 0.0f)
+                {
+                    phase = SyncVoice(
+                        sync_state, phase, voice_increment, sync_time);
+                }
+            }
+
+            voice_phase_[v] = phase;
+            mix += ReadBanks(morph, phase);
+        }
+        return mix * voice_gain_;
+    }
+
+    /**
+    Sync for voices 1 and up: the same resets as Sync(), but without the
+    residuals. FLIP needs nothing here, all voices share is_flipped_.
+    */
+    static float
+    SyncVoice(uint8_t sync_state, float phase, float increment, float t)
+    {
+        const float edge_phase = Wrap(phase - increment * t);
+
+        const bool reset
+            = sync_state == AppState::SYNC_MODES::HARD
+              || (sync_state == AppState::SYNC_MODES::SOFT
+                  && edge_phase <= 0.25f);
+        return reset ? Wrap(increment * t) : phase;
+    }
+
+    /**
+    Applies the sync mode to an edge `t` samples back and returns the new
+    phase. Rather than oscillating around the edge (PLL), the jump in value
+    and slope of the morphed wave at the edge is measured and handed out as
+    PolyBLEP residuals, so the cost is per edge rather than per sample.
+    */
+    float
+    Sync(const Morph& morph, uint8_t sync_state, float phase, float f0, float t)
+    {
+        const float increment  = is_flipped_ ? f0 : -f0;
+        const float edge_phase = Wrap(phase - increment * t);
+
+        float new_edge_phase = edge_phase;
+        float new_increment  = increment;
+        switch(sync_state)
+        {
+            case AppState::SYNC_MODES::HARD:
+            {
+                new_edge_phase = 0.0f;
+                break;
+            }
+            // Orange
+            case AppState::SYNC_MODES::SOFT:
+            {
+                if(edge_phase <= 0.25f)
+                {
+                    new_edge_phase = 0.0f;
+                }
+                break;
+            }
+            case AppState::SYNC_MODES::FLIP:
+            {
+                is_flipped_   = !is_flipped_;
+                new_increment = -increment;
+                break;
+            }
+            default: break;
+        }
+
+        if(new_edge_phase == edge_phase && new_increment == increment)
+        {
+            return phase;
+        }
+
+        float before = ReadMorph(morph, edge_phase);
+        float after  = ReadMorph(morph, new_edge_phase);
+        float step   = after - before;
+        float kink   = Slope(morph, new_edge_phase, after) * new_increment
+                     - Slope(morph, edge_phase, before) * increment;
+
+        blep_this_ = step * ThisBlepSample(t)
+                     + kink * ThisIntegratedBlepSample(t);
+        blep_next_ = step * NextBlepSample(t)
+                     + kink * NextIntegratedBlepSample(t);
+
+        return Wrap(new_edge_phase + new_increment * t);
+    }
+
+    // Slope of the morphed wave per unit of phase, across one table step
+    float Slope(const Morph& morph, float phase, float value)
+    {
+        static constexpr float kStep = 1.0f / float(wavetable_size);
+        return (ReadMorph(morph, Wrap(phase + kStep)) - value)
+               * float(wavetable_size);
+    }
+
+    static inline float Wrap(float phase) { return phase - floorf(phase); }
+
+    // Blend of the waves around the morph position at `phase`
+    float ReadMorph(const Morph& morph, float phase)
+    {
+        return ReadMorph(morph, phase, wavetable_);
+    }
+
+    // Same, from the bank starting at `waves`
+    float ReadMorph(const Morph& morph, float phase, float** waves)
+    {
+        int32_t p_integral;
+        float   p_fractional;
+        SplitPhase(phase, &p_integral, &p_fractional);
+
+        return Blend(morph, PhaseTap{waves, p_integral, p_fractional});
+    }
+
+    // ReadBlend(), crossfaded with the outgoing bank while a fade runs
+    inline float ReadBanks(const Morph& morph, float phase)
+    {
+        float mix = ReadBlend(morph, phase);
+        if(fade_active_)
+        {
+            mix = mix * fade_gain_in_
+                  + ReadMorph(morph, phase, fade_from_) * fade_gain_out_;
+        }
+        return mix;
+    }
+
+    // Moves the bank fade on by `rate` samples and updates its gains
+    void AdvanceFade(float rate)
+    {
+        fade_position_ += fade_increment_ * rate;
+        if(fade_position_ >= 1.0f)
+        {
+            fade_active_ = false;
+            return;
+        }
+        fade_gain_in_  = EqualPowerGain(fade_position_);
+        fade_gain_out_ = EqualPowerGain(1.0f - fade_position_);
+    }
+
+    // sin(x * pi / 2) for x in [0, 1], within 6e-4 and exact at both ends
+    static inline float EqualPowerGain(float x)
+    {
+        const float x2 = x * x;
+        return x * (1.5707963f + x2 * (-0.6459641f + x2 * 0.0751678f));
+    }
+
+    static inline void
+    SplitPhase(float phase, int32_t* p_integral, float* p_fractional)
+    {
+        // TODO: ensure that this "off by one" thing is correct and glitch-free
+        const float p     = phase * float(wavetable_size) - 1;
+        const float floor = floorf(p);
+        *p_integral       = static_cast<int32_t>(floor);
+        *p_fractional     = p - floor;
+    }
+
+    /**
+    Same as ReadMorph(), but reads from a lazily filled copy of the blended
+    wave once the morph position has held still for a while. Each table
+    index is blended the first time the phase lands on it, so a static
+    timbre costs two taps per sample. A moving one goes straight to
+    ReadMorph().
+    */
+    float ReadBlend(const Morph& morph, float phase)
+    {
+        if(!SameMorph(morph, blend_key_))
+        {
+            blend_key_    = morph;
+            blend_dirty_  = true;
+            blend_settle_ = 0;
+            return ReadMorph(morph, phase);
+        }
+
+        if(blend_dirty_)
+        {
+            // Only worth filling once the position has stopped moving
+            if(++blend_settle_ < kBlendSettleSamples)
+            {
+                return ReadMorph(morph, phase);
+            }
+            std::fill(&blend_valid_[0], &blend_valid_[kBlendWords], 0u);
+            blend_dirty_ = false;
+        }
+
+        int32_t p_integral;
+        float   p_fractional;
+        SplitPhase(phase, &p_integral, &p_fractional);
+
+        return PhaseInterpolation::Read(
+            BlendSample{this}, p_integral, p_fractional);
+    }
+
+    struct BlendSample
+    {
+        WavetableOscillator* oscillator;
+
+        inline float operator()(int32_t index) const
+        {
+            return oscillator->BlendAt(index);
+        }
+    };
+
+    inline float BlendAt(int32_t index)
+    {
+        index &= wavetable_size - 1;
+
+        uint32_t&      word = blend_valid_[index >> 5];
+        const uint32_t bit  = 1u << (index & 31);
+        if(!(word & bit))
+        {
+            blend_[index] = BlendCorners(blend_key_, index);
+            word |= bit;
+        }
+        return blend_[index];
+    }
+
+    // Blend of the waves around the morph position at one table index
+    float BlendCorners(const Morph& morph, int32_t index)
+    {
+        return Blend(morph, IndexTap{wavetable_, index});
+    }
+
+    // Weights closer than this reuse the cached blend; the error is well
+    // under the ADC noise on the position CVs.
+    static constexpr float kBlendTolerance = 1.0f / 4096.0f;
+
+    // About a millisecond at 48 kHz
+    static constexpr size_t kBlendSettleSamples = 48;
+
+    static inline bool SameMorph(const Morph& a, const Morph& b)
+    {
+        return a.x_integral == b.x_integral && a.y_integral == b.y_integral
+               && a.z_integral == b.z_integral
+               && fabsf(a.x_fractional - b.x_fractional) < kBlendTolerance
+               && fabsf(a.y_fractional - b.y_fractional) < kBlendTolerance
+               && fabsf(a.z_fractional - b.z_fractional) < kBlendTolerance;
     }
 
-  private:
     // Oscillator state.
     float phase_;
 
-    bool prev_sync_;
+    ParamValues    values_;
+    Params<Schema> params_;
+
     bool is_flipped_;
 
+    float max_frequency_ = kMaxFrequency;
+
+    // Rising edges on the sync input for the current block
+    SyncDetector sync_detector_;
+    SyncEdges    sync_edges_;
+
+    // Sync residuals and the sample held back so they can be applied
+    float blep_this_      = 0.0f;
+    float blep_next_      = 0.0f;
+    float delayed_sample_ = 0.0f;
+
+    // LFO mode decimation
+    size_t decimation_         = 1;
+    size_t decimation_counter_ = 0;
+    float  prev_sample_        = 0.0f;
+    float  next_sample_        = 0.0f;
+    bool   sync_pending_       = false;
+
+    // Oversampled WAVESHAPING / XOR
+    static constexpr size_t kMaxOversampling = 4;
+
+    size_t                oversampling_        = 1;
+    bool                  oversampling_active_ = false;
+    float                 previous_mod_input_  = 0.0f;
+    HalfbandDecimator<10> decimator_2x_;
+    HalfbandDecimator<4>  decimator_4x_;
+
+    // Unison / chord voices. Voice 0 is phase_, its ratio is always 1.
+    size_t voices_     = 1;
+    float  voice_gain_ = 1.0f;
+    float  voice_ratio_[kMaxVoices];
+    float  voice_phase_[kMaxVoices];
+
+    // Equal-power crossfade away from the previous bank
+    bool    fade_active_;
+    float** fade_from_;
+    float   fade_position_;
+    float   fade_increment_;
+    float   fade_gain_in_;
+    float   fade_gain_out_;
+
+    // Lazily blended wave for the current morph position
+    static constexpr size_t kBlendWords = wavetable_size / 32;
+
+    Morph    blend_key_;
+    bool     blend_dirty_;
+    size_t   blend_settle_;
+    float    blend_[wavetable_size];
+    uint32_t blend_valid_[kBlendWords];
+
     float** wavetable_;
     float** all_waves_;
 